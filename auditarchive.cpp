@@ -0,0 +1,293 @@
+#include "auditarchive.h"
+#include "connectionpool.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QFileInfo>
+#include <QPair>
+#include <QDir>
+#include <QSettings>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <algorithm>
+#include <utility>
+
+namespace {
+const int kChunkRows = 4096; // 也是热表每批删除的行数上限
+const quint32 kPackVersion = 1;
+const char kIsoFormat[] = "yyyy-MM-ddThh:mm:ss";
+
+bool execOrFail(QSqlQuery &q, const QString &sql, QString *error)
+{
+    if (q.exec(sql)) return true;
+    if (error) *error = q.lastError().text();
+    return false;
+}
+
+void sortAndDedupe(QVector<AuditEntry> *rows)
+{
+    std::sort(rows->begin(), rows->end(), [](const AuditEntry &a, const AuditEntry &b) {
+        return a.createdAt != b.createdAt ? a.createdAt < b.createdAt : a.id < b.id;
+    });
+    // 归档提交后、热表删除前中断时，同一行会同时出现在两边
+    rows->erase(std::unique(rows->begin(), rows->end(),
+                            [](const AuditEntry &a, const AuditEntry &b) { return a.id == b.id; }),
+                rows->end());
+}
+}
+
+QString AuditArchive::archivePath()
+{
+    const QString dbPath = ConnectionPool::instance().databasePath();
+    return QFileInfo(dbPath).absoluteDir().filePath("audit_archive.db");
+}
+
+int AuditArchive::retentionDays()
+{
+    return qMax(1, QSettings().value("audit/retention_days", 90).toInt());
+}
+
+bool AuditArchive::attach(const QSqlDatabase &db, QString *error)
+{
+    QSqlQuery q(db);
+    q.prepare("ATTACH DATABASE ? AS archive");
+    q.addBindValue(archivePath());
+    if (!q.exec()) {
+        if (error) *error = q.lastError().text();
+        return false;
+    }
+    // 按月分区：一个块只含同一月份的行；按 end_at 索引以便时间范围查询只解压重叠的块
+    return execOrFail(q, R"(CREATE TABLE IF NOT EXISTS archive.audit_chunks (
+                               id INTEGER PRIMARY KEY,
+                               month TEXT NOT NULL,
+                               first_id INTEGER NOT NULL,
+                               last_id INTEGER NOT NULL,
+                               start_at TEXT NOT NULL,
+                               end_at TEXT NOT NULL,
+                               row_count INTEGER NOT NULL,
+                               payload BLOB NOT NULL))", error)
+            && execOrFail(q, "CREATE INDEX IF NOT EXISTS archive.idx_chunk_end ON audit_chunks(end_at)", error);
+}
+
+void AuditArchive::detach(const QSqlDatabase &db)
+{
+    QSqlQuery q(db);
+    if (!q.exec("DETACH DATABASE archive")) {
+        qWarning() << "AuditArchive: detach failed" << q.lastError().text();
+    }
+}
+
+QByteArray AuditArchive::pack(const QVector<AuditEntry> &rows)
+{
+    QByteArray raw;
+    QDataStream out(&raw, QIODevice::WriteOnly);
+    out << kPackVersion << quint32(rows.size());
+    for (const AuditEntry &e : rows) {
+        out << e.id << e.action << e.actor << e.target << e.detail << e.createdAt;
+    }
+    return raw;
+}
+
+QVector<AuditEntry> AuditArchive::unpack(const QByteArray &payload)
+{
+    QVector<AuditEntry> rows;
+    const QByteArray raw = qUncompress(payload);
+    QDataStream in(raw);
+    quint32 version = 0;
+    quint32 count = 0;
+    in >> version >> count;
+    if (version != kPackVersion) {
+        qWarning() << "AuditArchive: unknown chunk version" << version;
+        return rows;
+    }
+    rows.reserve(int(count));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        AuditEntry e;
+        in >> e.id >> e.action >> e.actor >> e.target >> e.detail >> e.createdAt;
+        rows << e;
+    }
+    return rows;
+}
+
+bool AuditArchive::compact(const QDateTime &cutoff, AuditCompactStats *stats, QString *error)
+{
+    AuditCompactStats local;
+    AuditCompactStats &s = stats ? *stats : local;
+    ConnectionLease lease;
+    if (!lease.isValid()) {
+        if (error) *error = lease.errorText();
+        return false;
+    }
+    QSqlDatabase db = lease.database();
+    if (!attach(db, error)) return false;
+
+    // 不按已归档的最大 id 续做：id 与 created_at 不同序，水位线以下可能还有刚过期、未归档的行。
+    // 每次都取全部过期行，删除时只删本次写进归档块的 id 区间
+    bool ok = true;
+    const QString cutoffText = cutoff.toString(kIsoFormat);
+    QVector<QPair<qint64, qint64>> archived; // 每块的 (first_id, last_id)
+
+    // 第一步：写入归档库并提交
+    if (db.transaction()) {
+        QSqlQuery rows(db);
+        rows.setForwardOnly(true);
+        rows.prepare(R"(SELECT id, action, actor, target, detail, created_at FROM main.audit_logs
+                        WHERE created_at < ? ORDER BY id)");
+        rows.addBindValue(cutoffText);
+        QSqlQuery insert(db);
+        insert.prepare(R"(INSERT INTO archive.audit_chunks(month, first_id, last_id, start_at, end_at, row_count, payload)
+                          VALUES(?,?,?,?,?,?,?))");
+
+        QVector<AuditEntry> chunk;
+        auto flushChunk = [&]() {
+            if (chunk.isEmpty()) return true;
+            QString startAt = chunk.first().createdAt;
+            QString endAt = startAt;
+            for (const AuditEntry &e : std::as_const(chunk)) {
+                startAt = qMin(startAt, e.createdAt);
+                endAt = qMax(endAt, e.createdAt);
+            }
+            const QByteArray raw = pack(chunk);
+            const QByteArray payload = qCompress(raw, 6);
+            insert.addBindValue(startAt.left(7));
+            insert.addBindValue(chunk.first().id);
+            insert.addBindValue(chunk.last().id);
+            insert.addBindValue(startAt);
+            insert.addBindValue(endAt);
+            insert.addBindValue(chunk.size());
+            insert.addBindValue(payload);
+            if (!insert.exec()) {
+                if (error) *error = insert.lastError().text();
+                return false;
+            }
+            ++s.chunks;
+            s.rows += chunk.size();
+            s.rawBytes += raw.size();
+            s.storedBytes += payload.size();
+            archived << qMakePair(chunk.first().id, chunk.last().id);
+            chunk.clear();
+            return true;
+        };
+
+        ok = rows.exec();
+        if (!ok && error) *error = rows.lastError().text();
+        while (ok && rows.next()) {
+            AuditEntry e;
+            e.id = rows.value(0).toLongLong();
+            e.action = rows.value(1).toString();
+            e.actor = rows.value(2).toString();
+            e.target = rows.value(3).toString();
+            e.detail = rows.value(4).toString();
+            e.createdAt = rows.value(5).toString();
+            // 跨月或块已满时封块，保证一个块只属于一个月
+            if (!chunk.isEmpty() && (chunk.size() >= kChunkRows || e.createdAt.left(7) != chunk.first().createdAt.left(7))) {
+                ok = flushChunk();
+            }
+            chunk << e;
+        }
+        if (ok) ok = flushChunk();
+        rows.finish();
+        if (ok) ok = db.commit();
+        if (!ok) {
+            if (error && error->isEmpty()) *error = db.lastError().text();
+            db.rollback();
+            archived.clear();
+        }
+    } else {
+        ok = false;
+        if (error) *error = db.lastError().text();
+    }
+
+    // 第二步：逐块删除热表中刚归档的行，每块一个短事务，不长时间占住写锁。
+    // 审计行只追加不修改，新行的 id 大于所有已有行，区间内早于 cutoff 的行正是写进该块的那些
+    if (ok && !archived.isEmpty()) {
+        QSqlQuery del(db);
+        del.prepare("DELETE FROM main.audit_logs WHERE id BETWEEN ? AND ? AND created_at < ?");
+        for (const auto &range : std::as_const(archived)) {
+            if (!db.transaction()) {
+                ok = false;
+                if (error) *error = db.lastError().text();
+                break;
+            }
+            del.addBindValue(range.first);
+            del.addBindValue(range.second);
+            del.addBindValue(cutoffText);
+            ok = del.exec() && db.commit();
+            if (!ok) {
+                if (error) *error = del.lastError().isValid() ? del.lastError().text() : db.lastError().text();
+                db.rollback();
+                break;
+            }
+        }
+    }
+    detach(db);
+    return ok;
+}
+
+QVector<AuditEntry> AuditArchive::queryArchive(const QSqlDatabase &db, const QString &from, const QString &to,
+                                               QString *error)
+{
+    QVector<AuditEntry> out;
+    if (!QFileInfo::exists(archivePath())) return out;
+    if (!attach(db, error)) return out;
+    {
+        QSqlQuery q(db);
+        q.setForwardOnly(true);
+        q.prepare("SELECT payload FROM archive.audit_chunks WHERE end_at >= ? AND start_at <= ? ORDER BY first_id");
+        q.addBindValue(from);
+        q.addBindValue(to);
+        if (!q.exec()) {
+            if (error) *error = q.lastError().text();
+        }
+        while (q.next()) {
+            for (const AuditEntry &e : unpack(q.value(0).toByteArray())) {
+                if (e.createdAt >= from && e.createdAt <= to) out << e;
+            }
+        }
+    }
+    detach(db);
+    return out;
+}
+
+QVector<AuditEntry> AuditArchive::query(const QDateTime &from, const QDateTime &to, QString *error)
+{
+    QVector<AuditEntry> out;
+    ConnectionLease lease;
+    if (!lease.isValid()) {
+        if (error) *error = lease.errorText();
+        return out;
+    }
+    // 先确保刚入队的条目已落库
+    AuditSink::instance().flush();
+    const QString fromText = from.toString(kIsoFormat);
+    const QString toText = to.toString(kIsoFormat);
+    {
+        QSqlQuery q(lease.database());
+        q.setForwardOnly(true);
+        q.prepare(R"(SELECT id, action, actor, target, detail, created_at FROM audit_logs
+                     WHERE created_at BETWEEN ? AND ? ORDER BY created_at, id)");
+        q.addBindValue(fromText);
+        q.addBindValue(toText);
+        if (!q.exec()) {
+            if (error) *error = q.lastError().text();
+            return out;
+        }
+        while (q.next()) {
+            AuditEntry e;
+            e.id = q.value(0).toLongLong();
+            e.action = q.value(1).toString();
+            e.actor = q.value(2).toString();
+            e.target = q.value(3).toString();
+            e.detail = q.value(4).toString();
+            e.createdAt = q.value(5).toString();
+            out << e;
+        }
+    }
+    // 热表覆盖保留期内的时间段，更早的部分才需要解压归档
+    const QDateTime hotStart = QDateTime::currentDateTime().addDays(-retentionDays());
+    if (from < hotStart) {
+        out += queryArchive(lease.database(), fromText, toText, error);
+        sortAndDedupe(&out);
+    }
+    return out;
+}
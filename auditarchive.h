@@ -0,0 +1,42 @@
+#pragma once
+
+#include "auditsink.h"
+
+#include <QDateTime>
+#include <QSqlDatabase>
+#include <QString>
+#include <QVector>
+
+struct AuditCompactStats {
+    int chunks { 0 };        // 新写入的归档块
+    qint64 rows { 0 };       // 移出热表的行数
+    qint64 rawBytes { 0 };   // 压缩前
+    qint64 storedBytes { 0 };
+};
+
+// 审计日志冷热分离：热表 audit_logs 只保留最近 audit/retention_days（默认 90）天，
+// 更早的行按月分区、每块至多 4096 行，序列化后 qCompress 存入附加库 audit_archive.db 的 audit_chunks。
+// 压缩先提交归档块、再按块逐批删除本次写入的行；中途失败时遗留在热表的行下次会再归档一次，
+// 查询时按 id 去重。
+class AuditArchive
+{
+public:
+    // 与主库同目录的归档库文件
+    static QString archivePath();
+    static int retentionDays();
+
+    // 把 created_at 早于 cutoff 的行移入归档库；在持有写连接的线程调用（审计写入线程）
+    static bool compact(const QDateTime &cutoff, AuditCompactStats *stats = nullptr, QString *error = nullptr);
+
+    // 按时间范围 [from, to] 跨热表与归档查询，结果按 (created_at, id) 升序
+    static QVector<AuditEntry> query(const QDateTime &from, const QDateTime &to, QString *error = nullptr);
+    // 只读归档部分，供只覆盖热表的查询补齐更早的时间段
+    static QVector<AuditEntry> queryArchive(const QSqlDatabase &db, const QString &from, const QString &to,
+                                            QString *error = nullptr);
+
+private:
+    static bool attach(const QSqlDatabase &db, QString *error);
+    static void detach(const QSqlDatabase &db);
+    static QByteArray pack(const QVector<AuditEntry> &rows);
+    static QVector<AuditEntry> unpack(const QByteArray &payload);
+};
@@ -0,0 +1,226 @@
+#include "auditsink.h"
+#include "auditarchive.h"
+#include "connectionpool.h"
+#include "statementcache.h"
+
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QSettings>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <algorithm>
+
+namespace {
+const char kInsertAudit[] = "INSERT INTO audit_logs(action, actor, target, detail, created_at) VALUES(?,?,?,?,?)";
+// 退出时写库仍失败的重试次数，之后丢弃并告警
+const int kShutdownRetries = 3;
+}
+
+AuditSink &AuditSink::instance()
+{
+    static AuditSink sink;
+    return sink;
+}
+
+AuditSink::AuditSink()
+{
+    QSettings settings;
+    m_batchSize = qMax(1, settings.value("audit/batch_size", 64).toInt());
+    m_flushMs = qMax(10, settings.value("audit/flush_ms", 500).toInt());
+    m_compactMs = qMax(1, settings.value("audit/compact_hours", 24).toInt()) * 3600 * qint64(1000);
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("AuditSink");
+    m_thread->start(QThread::LowPriority);
+}
+
+AuditSink::~AuditSink()
+{
+    shutdown();
+}
+
+void AuditSink::push(Node *node)
+{
+    Node *head = m_head.loadRelaxed();
+    do {
+        node->next = head;
+    } while (!m_head.testAndSetRelease(head, node, head));
+}
+
+QVector<AuditEntry> AuditSink::takeAll()
+{
+    Node *node = m_head.fetchAndStoreAcquire(nullptr);
+    m_queued.storeRelaxed(0);
+    QVector<AuditEntry> entries;
+    while (node) {
+        entries << std::move(node->entry);
+        Node *next = node->next;
+        delete node;
+        node = next;
+    }
+    // 栈序为后进先出，反转后与入队顺序一致
+    std::reverse(entries.begin(), entries.end());
+    return entries;
+}
+
+void AuditSink::log(const QString &action, const QString &actor, const QString &target, const QString &detail)
+{
+    AuditEntry entry { action, actor, target, detail, QDateTime::currentDateTime().toString(Qt::ISODate) };
+    if (m_stopping.loadAcquire()) {
+        // 后台线程已停止：退化为在调用线程同步写入
+        const bool ok = writeBatch({ entry });
+        QMutexLocker locker(&m_mutex);
+        ++m_stats.queued;
+        (ok ? m_stats.written : m_stats.dropped) += 1;
+        return;
+    }
+    push(new Node { std::move(entry), nullptr });
+    ++m_enqueued;
+    if (m_queued.fetchAndAddRelaxed(1) + 1 == m_batchSize) m_wake.release();
+}
+
+bool AuditSink::flush(int timeoutMs)
+{
+    const quint64 target = m_enqueued.loadAcquire();
+    m_wake.release();
+    QDeadlineTimer deadline(timeoutMs);
+    QMutexLocker locker(&m_mutex);
+    while (m_done < target) {
+        if (!m_doneChanged.wait(&m_mutex, deadline)) return false;
+    }
+    return true;
+}
+
+void AuditSink::shutdown()
+{
+    if (!m_thread) return;
+    m_stopping.storeRelease(1);
+    m_wake.release();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    // 与停止标志竞争、在后台线程退出后才压入的条目
+    const QVector<AuditEntry> rest = takeAll();
+    if (!rest.isEmpty()) {
+        const bool ok = writeBatch(rest);
+        QMutexLocker locker(&m_mutex);
+        (ok ? m_stats.written : m_stats.dropped) += rest.size();
+        m_done += rest.size();
+        m_doneChanged.wakeAll();
+    }
+}
+
+AuditStats AuditSink::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    AuditStats s = m_stats;
+    s.queued = m_enqueued.loadRelaxed() + s.queued;
+    return s;
+}
+
+void AuditSink::markDone(quint64 count)
+{
+    QMutexLocker locker(&m_mutex);
+    m_done += count;
+    m_doneChanged.wakeAll();
+}
+
+bool AuditSink::writeBatch(const QVector<AuditEntry> &entries)
+{
+    ConnectionLease lease;
+    if (!lease.isValid()) {
+        qWarning() << "AuditSink: no database connection" << lease.errorText();
+        return false;
+    }
+    QSqlDatabase db = lease.database();
+    // 一批一个事务：一次提交（一次 fsync）代替逐条的隐式事务
+    if (!db.transaction()) {
+        qWarning() << "AuditSink: begin failed" << db.lastError().text();
+        return false;
+    }
+    {
+        const StatementLease stmt = ConnectionPool::instance().statements()->prepared(kInsertAudit);
+        QSqlQuery &q = stmt.query();
+        for (const AuditEntry &e : entries) {
+            q.addBindValue(e.action);
+            q.addBindValue(e.actor);
+            q.addBindValue(e.target);
+            q.addBindValue(e.detail);
+            q.addBindValue(e.createdAt);
+            if (!q.exec()) {
+                qWarning() << "AuditSink: insert failed" << q.lastError().text();
+                db.rollback();
+                return false;
+            }
+        }
+    }
+    if (!db.commit()) {
+        qWarning() << "AuditSink: commit failed" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+    return true;
+}
+
+void AuditSink::compact()
+{
+    AuditCompactStats s;
+    QString err;
+    const QDateTime cutoff = QDateTime::currentDateTime().addDays(-AuditArchive::retentionDays());
+    if (!AuditArchive::compact(cutoff, &s, &err)) {
+        qWarning() << "AuditSink: compaction failed" << err;
+        return;
+    }
+    if (s.rows > 0) {
+        qInfo("Audit archive: moved %lld rows into %d chunks (%lld -> %lld bytes)",
+              s.rows, s.chunks, s.rawBytes, s.storedBytes);
+    }
+    QMutexLocker locker(&m_mutex);
+    m_stats.archived += s.rows;
+}
+
+void AuditSink::run()
+{
+    QVector<AuditEntry> pending; // 写失败的条目，下一轮与新条目一起重试
+    int shutdownFailures = 0;
+    QElapsedTimer sinceCompact;
+    bool compacted = false;
+    for (;;) {
+        m_wake.tryAcquire(1, m_flushMs);
+        const bool stopping = m_stopping.loadAcquire();
+        // 启动后首个空闲周期做一次，之后按间隔；数据库路径在登录后才设置，未就绪时下轮再试
+        if (!stopping && (!compacted || sinceCompact.hasExpired(m_compactMs))
+                && !ConnectionPool::instance().databasePath().isEmpty()) {
+            compact();
+            compacted = true;
+            sinceCompact.start();
+        }
+        pending += takeAll();
+        if (!pending.isEmpty()) {
+            const quint64 count = pending.size();
+            if (writeBatch(pending)) {
+                {
+                    QMutexLocker locker(&m_mutex);
+                    m_stats.written += count;
+                    ++m_stats.batches;
+                }
+                pending.clear();
+                markDone(count);
+            } else if (stopping && ++shutdownFailures >= kShutdownRetries) {
+                qWarning() << "AuditSink: dropping" << count << "audit entries after repeated failures";
+                {
+                    QMutexLocker locker(&m_mutex);
+                    m_stats.dropped += count;
+                }
+                pending.clear();
+                markDone(count);
+            }
+        }
+        if (stopping && pending.isEmpty() && !m_head.loadAcquire()) break;
+        if (stopping) m_wake.release(); // 退出前不再等待间隔，立即处理剩余条目
+    }
+    // 本线程的连接在线程结束时由连接池关闭
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QAtomicInteger>
+#include <QAtomicPointer>
+#include <QMutex>
+#include <QSemaphore>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+
+class QThread;
+
+struct AuditEntry {
+    QString action;
+    QString actor;
+    QString target;
+    QString detail;
+    QString createdAt; // ISO，入队时取时间
+    qint64 id { -1 };  // 落库后的行 id，仅查询结果中有效
+};
+
+struct AuditStats {
+    quint64 queued { 0 };   // 累计入队条数
+    quint64 written { 0 };  // 累计写入条数
+    quint64 batches { 0 };  // 写入事务数
+    quint64 dropped { 0 };  // 退出时仍写不进去而丢弃的条数
+    quint64 archived { 0 }; // 累计移入归档库的条数
+};
+
+// 审计日志异步写入：log() 把条目压入无锁队列后立即返回（任意线程可调用），
+// 后台线程攒满一批（audit/batch_size，默认 64）或等待超时（audit/flush_ms，默认 500）后
+// 在一个事务内批量写入。写失败的条目保留到下一轮重试；shutdown() 写完全部已入队条目再停止。
+// 同一线程每 audit/compact_hours（默认 24）小时把超出保留期的行移入归档库（见 AuditArchive），
+// 与批量写入串行，不争用热表的写锁。
+class AuditSink
+{
+public:
+    static AuditSink &instance();
+
+    void log(const QString &action, const QString &actor, const QString &target = QString(),
+             const QString &detail = QString());
+    // 阻塞直到调用前入队的条目全部落库（或超时），读审计日志前使用
+    bool flush(int timeoutMs = 5000);
+    // 写完剩余条目并结束后台线程；之后的 log() 同步写入
+    void shutdown();
+
+    AuditStats stats() const;
+
+private:
+    AuditSink();
+    ~AuditSink();
+    Q_DISABLE_COPY(AuditSink)
+
+    // 多生产者单消费者：生产者 CAS 压栈，消费者一次取走整条链再反转成入队顺序
+    struct Node {
+        AuditEntry entry;
+        Node *next { nullptr };
+    };
+
+    void push(Node *node);
+    QVector<AuditEntry> takeAll();
+    bool writeBatch(const QVector<AuditEntry> &entries);
+    void run();
+    void markDone(quint64 count);
+    void compact();
+
+    QAtomicPointer<Node> m_head;
+    QAtomicInteger<quint64> m_enqueued { 0 };
+    QAtomicInteger<int> m_queued { 0 }; // 自上次取走后新入队的条数，用于按批唤醒
+    QAtomicInteger<int> m_stopping { 0 };
+    QSemaphore m_wake;
+    int m_batchSize;
+    int m_flushMs;
+    qint64 m_compactMs;
+    QThread *m_thread { nullptr };
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_doneChanged;
+    quint64 m_done { 0 }; // 已写入或丢弃的条数
+    AuditStats m_stats;
+};
@@ -0,0 +1,786 @@
+#include "campuscore.h"
+#include "auditsink.h"
+#include "connectionpool.h"
+#include "statementcache.h"
+#include "utils/csvwriter.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlError>
+#include <QSqlRecord>
+#include <utility>
+
+namespace {
+QueryRows collectRows(QSqlQuery &q)
+{
+    QueryRows out;
+    const QSqlRecord rec = q.record();
+    for (int i = 0; i < rec.count(); ++i) {
+        out.columns << rec.fieldName(i);
+    }
+    while (q.next()) {
+        QVariantList row;
+        row.reserve(rec.count());
+        for (int i = 0; i < rec.count(); ++i) {
+            row << q.value(i);
+        }
+        out.rows << row;
+    }
+    return out;
+}
+
+// 活动列表的筛选片段，拼在 "SELECT ... FROM activities" 之后
+struct ActivityFilterSql {
+    QString join;    // 关键字走全文索引时的排名子查询
+    QString where;   // 不含 WHERE 关键字
+    QString orderBy; // 全文检索按相关度排序
+    QVariantList binds;
+};
+
+// trigram 需要至少 3 个字符才能命中索引，更短的关键字走 LIKE
+bool useFullText(const ActivityFilter &f, bool ftsAvailable)
+{
+    return ftsAvailable && f.keyword.size() >= 3;
+}
+
+// 条件全部用占位符，SQL 文本只随启用的条件组合变化，便于语句缓存复用
+ActivityFilterSql activityFilterSql(const ActivityFilter &f, bool ftsAvailable)
+{
+    ActivityFilterSql out;
+    if (useFullText(f, ftsAvailable)) {
+        out.join = " JOIN (SELECT rowid AS fts_id, rank AS fts_rank FROM activities_fts WHERE activities_fts MATCH ?)"
+                   " ON fts_id=id";
+        // 限定标题/地点列的短语查询；短语内的双引号需成对转义
+        out.binds << QString("{title location} : \"%1\"").arg(QString(f.keyword).replace('"', "\"\""));
+        out.orderBy = " ORDER BY fts_rank";
+    }
+    QStringList filters;
+    if (f.role == "initiator") {
+        filters << "creator=?";
+        out.binds << f.username;
+    }
+    if (!f.category.isEmpty()) {
+        // 分类取自下拉框的完整取值，等值匹配可走 idx_activity_category
+        filters << "category=?";
+        out.binds << f.category;
+    }
+    if (!f.status.isEmpty()) {
+        filters << "status=?";
+        out.binds << f.status;
+    }
+    if (!f.keyword.isEmpty() && !useFullText(f, ftsAvailable)) {
+        const QString pattern = QString("%%1%").arg(f.keyword);
+        filters << "(title LIKE ? OR location LIKE ?)";
+        out.binds << pattern << pattern;
+    }
+    out.where = filters.join(" AND ");
+    return out;
+}
+
+QString placeholders(int count)
+{
+    QStringList marks;
+    for (int i = 0; i < count; ++i) marks << "?";
+    return marks.join(',');
+}
+
+// IN 列表的占位符个数向上取整到 2 的幂，ID 个数不同的补丁共用少数几条缓存语句
+int inListArity(int count)
+{
+    int arity = 1;
+    while (arity < count) arity *= 2;
+    return arity;
+}
+
+// 多出的占位符绑定 -1（主键从 1 开始，不会匹配任何行）
+void bindInList(QSqlQuery &q, const QList<int> &ids)
+{
+    for (int id : ids) q.addBindValue(id);
+    for (int i = ids.size(); i < inListArity(ids.size()); ++i) q.addBindValue(-1);
+}
+
+ActionResult rejectedAction(const QString &action, const QString &error)
+{
+    ActionResult r;
+    r.action = action;
+    r.rejected = true;
+    r.error = error;
+    return r;
+}
+
+// 分页加载与增量查询共用同一列清单，保证增量行与模型列一致
+const char kActivityColumns[] = "id, title, category, location, start_time, end_time, capacity, approver, status, creator";
+const char kAvailableSelect[] = R"(SELECT a.id, a.title AS 标题, a.category AS 类别, a.location AS 地点,
+                               a.start_time AS 开始, a.end_time AS 结束, a.capacity AS 容量,
+                               a.enrolled_count AS 已报名
+                               FROM activities a WHERE a.status='approved')";
+const char kMyEnrollmentSelect[] = R"(SELECT e.id, a.title AS 标题, a.start_time AS 开始, a.end_time AS 结束,
+                               e.status AS 状态, e.position AS 候补序号
+                               FROM enrollments e
+                               JOIN activities a ON e.activity_id=a.id
+                               WHERE e.student=?)";
+}
+
+CampusCore::CampusCore() = default;
+
+CampusCore::~CampusCore()
+{
+    // 先释放引擎的预编译语句，再归还连接；m_db 析构时归还它自己的连接
+    delete m_engine;
+    m_engine = nullptr;
+    if (m_leased) {
+        m_conn = QSqlDatabase();
+        ConnectionPool::instance().release();
+    }
+}
+
+bool CampusCore::open(const QString &path, QString *error)
+{
+    delete m_engine;
+    m_engine = nullptr;
+    m_ftsAvailable = -1;
+    m_statsDirty = StatsAll;
+    m_statsDataVersion = -1;
+    m_conn = QSqlDatabase();
+    if (m_leased) {
+        ConnectionPool::instance().release();
+        m_leased = false;
+    }
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    if (m_db.open(path) && m_db.initSchema()) return true;
+
+    // 迁移失败多为锁冲突、磁盘满或个别数据问题：原样报告，不动库文件。
+    // 只有完整性检查确认损坏时才把库（连同 -wal/-shm）移到一旁再建新库
+    const QString failure = m_db.lastErrorText();
+    QString detail;
+    if (!m_db.database().isValid() || !m_db.isCorrupt(&detail)) {
+        m_db.close();
+        if (error) *error = failure;
+        return false;
+    }
+    m_db.close(true);
+    const QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss");
+    for (const QString &suffix : { QString(), QString("-wal"), QString("-shm") }) {
+        if (!QFile::exists(path + suffix)) continue;
+        if (!QFile::rename(path + suffix, QString("%1.corrupt-%2%3").arg(path, stamp, suffix))) {
+            if (error) *error = tr("数据库已损坏且无法移走 %1：%2").arg(path + suffix, detail);
+            return false;
+        }
+    }
+    qWarning() << "CampusCore: corrupt database moved aside:" << path << detail;
+    if (m_db.open(path) && m_db.initSchema()) return true;
+    if (error) *error = m_db.lastErrorText();
+    return false;
+}
+
+QSqlDatabase CampusCore::database()
+{
+    if (m_db.database().isValid()) return m_db.database();
+    // 未 open 时首次使用才借出本线程的连接，直到析构才归还
+    if (!m_conn.isValid()) {
+        QString err;
+        m_conn = ConnectionPool::instance().acquire(&err);
+        if (m_conn.isValid()) {
+            m_leased = true;
+        } else {
+            qWarning() << "CampusCore: no database connection" << err;
+        }
+    }
+    return m_conn;
+}
+
+StatementLease CampusCore::prepared(const QString &sql)
+{
+    database();
+    StatementCache *cache = ConnectionPool::instance().statements();
+    if (cache) return cache->prepared(sql);
+    // 无可用连接：返回无效语句，exec() 会失败并带出错误
+    m_invalidQuery = QSqlQuery();
+    return StatementLease(&m_invalidQuery);
+}
+
+bool CampusCore::ftsAvailable()
+{
+    // 迁移结果在进程内不变，首次查询后缓存
+    if (m_ftsAvailable < 0) m_ftsAvailable = DbManager::hasActivitySearch(database()) ? 1 : 0;
+    return m_ftsAvailable == 1;
+}
+
+EnrollmentEngine *CampusCore::engine()
+{
+    // 引擎持有的预编译语句绑定在本线程的连接上，首次使用时创建
+    if (!m_engine) {
+        m_engine = new EnrollmentEngine(database());
+    }
+    return m_engine;
+}
+
+void CampusCore::audit(const QString &actor, const ActionResult &r)
+{
+    // 入队即返回，由后台线程批量写入
+    if (r.ok) AuditSink::instance().log(r.action, actor, r.target, r.detail);
+}
+
+LoginResult CampusCore::login(const QString &username, const QString &password, const QString &role)
+{
+    LoginResult r;
+    if (username.isEmpty() || password.isEmpty() || role.isEmpty()) {
+        r.outcome = LoginResult::MissingInput;
+        r.error = tr("请输入用户名、密码并选择角色");
+        return r;
+    }
+    UserInfo info;
+    if (!m_db.validateUser(username, password, info)) {
+        r.outcome = LoginResult::BadCredentials;
+        r.error = tr("用户名或密码错误");
+        return r;
+    }
+    if (info.role != role) {
+        r.outcome = LoginResult::RoleMismatch;
+        r.error = tr("角色不匹配，当前账号角色：%1").arg(info.role);
+        return r;
+    }
+    r.outcome = LoginResult::LoggedIn;
+    r.user = info;
+    return r;
+}
+
+ActionResult CampusCore::registerUser(const QString &username, const QString &password, const QString &role)
+{
+    if (username.isEmpty() || password.isEmpty() || role.isEmpty()) {
+        return rejectedAction("register", tr("请输入用户名、密码并选择角色"));
+    }
+    ActionResult r;
+    r.action = "register";
+    r.target = username;
+    r.detail = QString("role=%1").arg(role);
+    r.ok = m_db.createUser(username, password, role, &r.error);
+    return r;
+}
+
+PageQuery CampusCore::activityPageQuery(const ActivityFilter &filter)
+{
+    const ActivityFilterSql f = activityFilterSql(filter, ftsAvailable());
+    PageQuery query;
+    query.columns = kActivityColumns;
+    query.from = "activities" + f.join;
+    query.where = f.where;
+    query.binds = f.binds;
+    // 全文检索按相关度，其余按开始时间（idx_activity_status_start_ts / idx_activity_time）
+    query.sortKey = f.orderBy.isEmpty() ? "start_ts" : "fts_rank";
+    return query;
+}
+
+PageResult CampusCore::fetchPage(const PageRequest &request)
+{
+    PageResult result;
+    result.generation = request.generation;
+    result.page = request.page;
+    const PageQuery &pq = request.query;
+
+    QStringList conds;
+    if (!pq.where.isEmpty()) conds << "(" + pq.where + ")";
+    QVariantList binds = pq.binds;
+    if (request.hasAnchor) {
+        // keyset：从上一页末行之后继续，(key, id) 作为全序，不用行值比较以兼容旧版 SQLite
+        const QString cmp = pq.descending ? "<" : ">";
+        conds << QString("(%1 %2 ? OR (%1 = ? AND %3 %2 ?))").arg(pq.sortKey, cmp, pq.idColumn);
+        binds << request.anchorKey << request.anchorKey << request.anchorId;
+    }
+    const QString dir = pq.descending ? " DESC" : "";
+    QString sql = QString("SELECT %1, %2 AS _page_key FROM %3").arg(pq.columns, pq.sortKey, pq.from);
+    if (!conds.isEmpty()) sql += " WHERE " + conds.join(" AND ");
+    sql += QString(" ORDER BY %1%2, %3%2 LIMIT ?").arg(pq.sortKey, dir, pq.idColumn);
+    binds << request.pageSize;
+    if (!request.hasAnchor && request.page > 0) {
+        // 跳页且没有锚点（如直接拖动滚动条）时才退回 OFFSET
+        sql += " OFFSET ?";
+        binds << qint64(request.page) * request.pageSize;
+    }
+    const StatementLease stmt = prepared(sql);
+    QSqlQuery &q = stmt.query();
+    for (const QVariant &v : std::as_const(binds)) q.addBindValue(v);
+    if (!q.exec()) {
+        result.error = q.lastError().text();
+        return result;
+    }
+    result.rows = collectRows(q);
+
+    if (request.withTotal) {
+        QString countSql = "SELECT COUNT(*) FROM " + pq.from;
+        if (!pq.where.isEmpty()) countSql += " WHERE " + pq.where;
+        const StatementLease countStmt = prepared(countSql);
+        QSqlQuery &c = countStmt.query();
+        for (const QVariant &v : pq.binds) c.addBindValue(v);
+        if (!c.exec() || !c.next()) {
+            result.error = c.lastError().text();
+            return result;
+        }
+        result.total = c.value(0).toInt();
+    }
+    return result;
+}
+
+RowPatch CampusCore::activityRows(const ActivityFilter &filter, const QList<int> &ids)
+{
+    RowPatch patch;
+    patch.ids = ids;
+    const ActivityFilterSql f = activityFilterSql(filter, ftsAvailable());
+    QString sql = QString("SELECT %1 FROM activities").arg(kActivityColumns) + f.join + " WHERE ";
+    if (!f.where.isEmpty()) sql += f.where + " AND ";
+    sql += QString("id IN (%1)").arg(placeholders(inListArity(ids.size())));
+    const StatementLease stmt = prepared(sql);
+    QSqlQuery &q = stmt.query();
+    for (const QVariant &v : f.binds) q.addBindValue(v);
+    bindInList(q, ids);
+    q.exec();
+    patch.rows = collectRows(q);
+    return patch;
+}
+
+PageQuery CampusCore::auditPageQuery(const AuditFilter &filter)
+{
+    AuditSink::instance().flush();
+    PageQuery query;
+    query.columns = "id, created_at, actor, action, target, detail";
+    query.from = "audit_logs";
+    // 时间范围总在最后，等值条件在前，对应 idx_audit_actor_time / idx_audit_action_time / idx_audit_time
+    QStringList conds;
+    if (!filter.actor.isEmpty()) {
+        conds << "actor=?";
+        query.binds << filter.actor;
+    }
+    if (!filter.action.isEmpty()) {
+        conds << "action=?";
+        query.binds << filter.action;
+    }
+    conds << "created_at BETWEEN ? AND ?";
+    query.binds << filter.from.toString(Qt::ISODate) << filter.to.toString(Qt::ISODate);
+    query.where = conds.join(" AND ");
+    query.sortKey = "created_at";
+    query.descending = true;
+    return query;
+}
+
+QueryRows CampusCore::upcoming()
+{
+    const StatementLease stmt = prepared(R"(SELECT title AS 标题, start_time AS 开始, end_time AS 结束, location AS 地点, status AS 状态
+                               FROM activities
+                               WHERE status!='cancelled' AND start_ts >= CAST(strftime('%s','now','localtime') AS INTEGER)
+                               ORDER BY start_ts LIMIT 20)");
+    QSqlQuery &q = stmt.query();
+    q.exec();
+    return collectRows(q);
+}
+
+QueryRows CampusCore::availableActivities()
+{
+    const StatementLease stmt = prepared(QString(kAvailableSelect) + " ORDER BY a.start_ts");
+    QSqlQuery &q = stmt.query();
+    q.exec();
+    return collectRows(q);
+}
+
+RowPatch CampusCore::availableActivityRows(const QList<int> &ids)
+{
+    RowPatch patch;
+    patch.ids = ids;
+    const StatementLease stmt = prepared(QString(kAvailableSelect) + QString(" AND a.id IN (%1)").arg(placeholders(inListArity(ids.size()))));
+    QSqlQuery &q = stmt.query();
+    bindInList(q, ids);
+    q.exec();
+    patch.rows = collectRows(q);
+    return patch;
+}
+
+QueryRows CampusCore::myEnrollments(const QString &student)
+{
+    const StatementLease stmt = prepared(QString(kMyEnrollmentSelect) + " ORDER BY a.start_ts");
+    QSqlQuery &q = stmt.query();
+    q.addBindValue(student);
+    q.exec();
+    return collectRows(q);
+}
+
+RowPatch CampusCore::myEnrollmentRows(const QString &student, const QList<int> &ids)
+{
+    RowPatch patch;
+    patch.ids = ids;
+    const StatementLease stmt = prepared(QString(kMyEnrollmentSelect) + QString(" AND e.id IN (%1)").arg(placeholders(inListArity(ids.size()))));
+    QSqlQuery &q = stmt.query();
+    q.addBindValue(student);
+    bindInList(q, ids);
+    q.exec();
+    patch.rows = collectRows(q);
+    return patch;
+}
+
+QStringList CampusCore::studentConflicts(const QString &student, QString *error)
+{
+    // 重叠判断在 SQL 中按整数时间完成，先开始者在前
+    const StatementLease stmt = prepared(R"(SELECT a1.title,
+              strftime('%m-%d %H:%M', a1.start_ts, 'unixepoch'), strftime('%m-%d %H:%M', a1.end_ts, 'unixepoch'),
+              a2.title,
+              strftime('%m-%d %H:%M', a2.start_ts, 'unixepoch'), strftime('%m-%d %H:%M', a2.end_ts, 'unixepoch')
+              FROM enrollments e1
+              JOIN activities a1 ON e1.activity_id=a1.id
+              JOIN enrollments e2 ON e2.student=e1.student AND e2.status='active' AND e2.id!=e1.id
+              JOIN activities a2 ON e2.activity_id=a2.id
+              WHERE e1.student=? AND e1.status='active' AND a1.status!='cancelled' AND a2.status!='cancelled'
+              AND a2.start_ts < a1.end_ts AND a1.start_ts < a2.end_ts
+              AND (a1.start_ts < a2.start_ts OR (a1.start_ts = a2.start_ts AND e1.id < e2.id))
+              ORDER BY a1.start_ts, a2.start_ts)");
+    QSqlQuery &q = stmt.query();
+    q.addBindValue(student);
+    QStringList conflicts;
+    if (!q.exec()) {
+        if (error) *error = q.lastError().text();
+        return conflicts;
+    }
+    while (q.next()) {
+        conflicts << tr("活动「%1」(%2-%3) 与 「%4」(%5-%6) 时间冲突")
+                        .arg(q.value(0).toString(), q.value(1).toString(), q.value(2).toString(),
+                             q.value(3).toString(), q.value(4).toString(), q.value(5).toString());
+    }
+    return conflicts;
+}
+
+DashboardStats CampusCore::stats()
+{
+    // 本连接的写入由 applyEnrollmentStats/invalidateActivity 增量维护；
+    // 其他连接（其他线程、loadgen、第二个客户端）提交过时 data_version 变化，只能整体重算
+    {
+        const StatementLease stmt = prepared("PRAGMA data_version");
+        QSqlQuery &q = stmt.query();
+        if (q.exec() && q.next()) {
+            const qint64 version = q.value(0).toLongLong();
+            if (version != m_statsDataVersion) {
+                if (m_statsDataVersion >= 0) m_statsDirty = StatsAll;
+                m_statsDataVersion = version;
+            }
+        }
+    }
+    if (m_statsDirty & StatsCounts) {
+        // 一次扫描 activities 得到全部数字：窗口聚合在 LIMIT 之前覆盖整表，前十名随同返回；
+        // 已报名总数取自计数列，不再扫描 enrollments
+        const StatementLease stmt = prepared(R"(SELECT id, title, enrolled_count,
+                                          COUNT(*) OVER (), SUM(status='approved') OVER (),
+                                          SUM(status='pending') OVER (), SUM(enrolled_count) OVER ()
+                                   FROM activities
+                                   ORDER BY enrolled_count DESC, id
+                                   LIMIT 10)");
+        QSqlQuery &q = stmt.query();
+        if (!q.exec()) {
+            qWarning() << "CampusCore: stats query failed" << q.lastError().text();
+            return m_stats;
+        }
+        m_stats.totalActivities = m_stats.approved = m_stats.pending = m_stats.activeEnrollments = 0;
+        m_stats.topActivities = QueryRows();
+        m_stats.topActivities.columns = QStringList{ tr("活动"), tr("报名人数") };
+        m_topIds.clear();
+        while (q.next()) {
+            m_stats.totalActivities = q.value(3).toInt();
+            m_stats.approved = q.value(4).toInt();
+            m_stats.pending = q.value(5).toInt();
+            m_stats.activeEnrollments = q.value(6).toInt();
+            if (q.value(2).toInt() <= 0) continue;
+            m_topIds << q.value(0).toInt();
+            m_stats.topActivities.rows << QVariantList{ q.value(1), q.value(2) };
+        }
+        q.finish();
+        m_statsDirty = 0;
+        ++m_stats.version;
+    } else if (m_statsDirty & StatsTop) {
+        loadTopActivities();
+        m_statsDirty = 0;
+        ++m_stats.version;
+    }
+    return m_stats;
+}
+
+void CampusCore::loadTopActivities()
+{
+    const StatementLease stmt = prepared(R"(SELECT id, title, enrolled_count FROM activities
+                               WHERE enrolled_count > 0
+                               ORDER BY enrolled_count DESC, id
+                               LIMIT 10)");
+    QSqlQuery &q = stmt.query();
+    m_stats.topActivities.rows.clear();
+    m_topIds.clear();
+    if (!q.exec()) {
+        qWarning() << "CampusCore: top activities query failed" << q.lastError().text();
+        return;
+    }
+    while (q.next()) {
+        m_topIds << q.value(0).toInt();
+        m_stats.topActivities.rows << QVariantList{ q.value(1), q.value(2) };
+    }
+}
+
+void CampusCore::applyEnrollmentStats(int activityId, int activeDelta, int enrolledCount)
+{
+    if (m_statsDirty & StatsCounts) return; // 下次读取时整体重算
+    if (activeDelta != 0) {
+        m_stats.activeEnrollments += activeDelta;
+        ++m_stats.version;
+    }
+    if (enrolledCount < 0 || (m_statsDirty & StatsTop)) return;
+
+    QVector<QVariantList> &rows = m_stats.topActivities.rows;
+    const int pos = m_topIds.indexOf(activityId);
+    const bool full = m_topIds.size() >= 10;
+    if (pos < 0) {
+        // 不在榜内：人数低于榜尾不影响排名，否则需要标题等信息，交给下次重查
+        if (enrolledCount <= 0) return;
+        if (full && enrolledCount < rows.last().value(1).toInt()) return;
+        m_statsDirty |= StatsTop;
+        return;
+    }
+    const int previous = rows.at(pos).value(1).toInt();
+    if (enrolledCount == previous) return;
+    if (enrolledCount < previous && full) {
+        // 榜内人数下降可能被榜外活动替换，只能重查
+        m_statsDirty |= StatsTop;
+        return;
+    }
+    // 人数上升或榜未满：就地调整并按 (人数降序, id) 重新定位
+    QVariantList row = rows.takeAt(pos);
+    m_topIds.removeAt(pos);
+    if (enrolledCount > 0) {
+        row[1] = enrolledCount;
+        int at = 0;
+        while (at < rows.size()
+               && (rows.at(at).value(1).toInt() > enrolledCount
+                   || (rows.at(at).value(1).toInt() == enrolledCount && m_topIds.at(at) < activityId))) {
+            ++at;
+        }
+        rows.insert(at, row);
+        m_topIds.insert(at, activityId);
+    }
+    ++m_stats.version;
+}
+
+void CampusCore::invalidateActivity(int activityId)
+{
+    // 状态、标题或删除都可能改变计数与前十名；时间或状态变化使引擎的区间缓存失效
+    m_statsDirty = StatsAll;
+    if (m_engine) m_engine->invalidateActivity(activityId);
+}
+
+ActionResult CampusCore::saveActivity(const UserInfo &user, ActivityDraft draft)
+{
+    const QString action = "activity_submit";
+    if (user.role != "initiator") return rejectedAction(action, tr("仅发起人可发布/编辑活动"));
+    draft.title = draft.title.trimmed();
+    if (draft.title.isEmpty()) return rejectedAction(action, tr("标题不能为空"));
+    if (draft.capacity <= 0) return rejectedAction(action, tr("容量必须大于 0"));
+    const QDateTime start = QDateTime::fromString(draft.startTime, Qt::ISODate);
+    const QDateTime end = QDateTime::fromString(draft.endTime, Qt::ISODate);
+    if (!start.isValid() || !end.isValid() || end <= start) {
+        return rejectedAction(action, tr("结束时间必须晚于开始时间"));
+    }
+    if (start < QDateTime::currentDateTime().addSecs(-60)) {
+        return rejectedAction(action, tr("开始时间不能早于当前时间"));
+    }
+    draft.creator = user.username;
+
+    ActionResult r;
+    r.action = action;
+    r.id = draft.id;
+    r.target = draft.title;
+    r.detail = draft.id < 0 ? "new" : "update";
+    const StatementLease stmt = draft.id < 0
+            ? prepared(R"(INSERT INTO activities(title, category, location, start_time, end_time, capacity, status, creator)
+                          VALUES(?,?,?,?,?,?, 'pending', ?))")
+            : prepared(R"(UPDATE activities SET title=?, category=?, location=?, start_time=?, end_time=?, capacity=? WHERE id=?)");
+    QSqlQuery &q = stmt.query();
+    q.addBindValue(draft.title);
+    q.addBindValue(draft.category);
+    q.addBindValue(draft.location);
+    q.addBindValue(draft.startTime);
+    q.addBindValue(draft.endTime);
+    q.addBindValue(draft.capacity);
+    q.addBindValue(draft.id < 0 ? QVariant(draft.creator) : QVariant(draft.id));
+    if (!q.exec()) {
+        r.error = q.lastError().text();
+        return r;
+    }
+    if (draft.id < 0) r.id = q.lastInsertId().toInt();
+    invalidateActivity(r.id);
+    r.ok = true;
+    audit(user.username, r);
+    return r;
+}
+
+ActionResult CampusCore::approveActivity(const UserInfo &user, int activityId)
+{
+    return setActivityStatus(user, activityId, "approved");
+}
+
+ActionResult CampusCore::rejectActivity(const UserInfo &user, int activityId)
+{
+    return setActivityStatus(user, activityId, "rejected");
+}
+
+ActionResult CampusCore::setActivityStatus(const UserInfo &user, int activityId, const QString &status)
+{
+    const bool approve = status == "approved";
+    const QString action = approve ? "activity_approve" : "activity_reject";
+    if (user.role != "admin") return rejectedAction(action, tr("仅管理员可审批"));
+    ActionResult r;
+    r.action = action;
+    r.id = activityId;
+    r.target = QString::number(activityId);
+    if (approve) r.detail = QString("approver=%1").arg(user.username);
+    const StatementLease stmt = approve
+            ? prepared("UPDATE activities SET status='approved', approver=? WHERE id=?")
+            : prepared("UPDATE activities SET status=? WHERE id=?");
+    QSqlQuery &q = stmt.query();
+    q.addBindValue(approve ? user.username : status);
+    q.addBindValue(activityId);
+    if (!q.exec()) {
+        r.error = q.lastError().text();
+        return r;
+    }
+    invalidateActivity(activityId);
+    r.ok = true;
+    audit(user.username, r);
+    return r;
+}
+
+ActionResult CampusCore::deleteActivity(const UserInfo &user, int activityId)
+{
+    if (user.role != "admin") return rejectedAction("activity_delete", tr("仅管理员可删除"));
+    ActionResult r;
+    r.action = "activity_delete";
+    r.id = activityId;
+    r.target = QString::number(activityId);
+    const StatementLease stmt = prepared("DELETE FROM activities WHERE id=?");
+    QSqlQuery &q = stmt.query();
+    q.addBindValue(activityId);
+    if (!q.exec()) {
+        r.error = q.lastError().text();
+        return r;
+    }
+    invalidateActivity(activityId);
+    r.ok = true;
+    audit(user.username, r);
+    return r;
+}
+
+bool CampusCore::warmStudent(const QString &student, QString *error)
+{
+    return engine()->warm(student, error);
+}
+
+EnrollResult CampusCore::enroll(const UserInfo &user, int activityId)
+{
+    if (user.role != "student") {
+        EnrollResult r;
+        r.activityId = activityId;
+        r.error = tr("仅学生可报名");
+        return r;
+    }
+    const EnrollResult r = engine()->enroll(activityId, user.username, EnrollmentEngine::Auto);
+    if (r.outcome == EnrollResult::Enrolled) {
+        applyEnrollmentStats(activityId, 1, r.enrolledCount);
+        AuditSink::instance().log("enroll", user.username, QString::number(activityId));
+    } else if (r.outcome == EnrollResult::Waitlisted) {
+        AuditSink::instance().log("waitlist", user.username, QString::number(activityId),
+                                  QString("position=%1").arg(r.position));
+    }
+    return r;
+}
+
+EnrollResult CampusCore::waitlist(const UserInfo &user, int activityId)
+{
+    if (user.role != "student") {
+        EnrollResult r;
+        r.activityId = activityId;
+        r.error = tr("仅学生可候补");
+        return r;
+    }
+    const EnrollResult r = engine()->enroll(activityId, user.username, EnrollmentEngine::WaitlistOnly);
+    if (r.outcome == EnrollResult::Waitlisted) {
+        AuditSink::instance().log("waitlist", user.username, QString::number(activityId),
+                                  QString("position=%1").arg(r.position));
+    }
+    return r;
+}
+
+CancelResult CampusCore::cancelEnrollment(const UserInfo &user, int enrollmentId)
+{
+    if (user.role != "student") {
+        CancelResult r;
+        r.enrollmentId = enrollmentId;
+        r.error = tr("仅学生可操作报名/候补");
+        return r;
+    }
+    const CancelResult r = engine()->cancel(enrollmentId, user.username);
+    if (r.ok) {
+        applyEnrollmentStats(r.activityId, (r.promotedId >= 0 ? 1 : 0) - (r.wasActive ? 1 : 0), r.enrolledCount);
+        AuditSink::instance().log("enroll_cancel", user.username, QString::number(enrollmentId));
+    }
+    return r;
+}
+
+ActionResult CampusCore::exportMyEnrollments(const UserInfo &user, const QString &path)
+{
+    if (user.role != "student") return rejectedAction("export_my_enroll", tr("仅学生可导出自己的报名"));
+    ActionResult r;
+    r.action = "export_my_enroll";
+    r.target = path;
+    CsvWriter writer;
+    if (!writer.open(path, &r.error)) return r;
+    const StatementLease stmt = prepared(R"(SELECT a.title, a.start_time, a.end_time, e.status
+                FROM enrollments e
+                JOIN activities a ON e.activity_id=a.id
+                WHERE e.student=?)");
+    QSqlQuery &q = stmt.query();
+    q.setForwardOnly(true);
+    q.addBindValue(user.username);
+    if (!q.exec()) {
+        // 查询失败时不留下只有表头或空的文件
+        r.error = q.lastError().text();
+        writer.close();
+        QFile::remove(path);
+        return r;
+    }
+    writer.writeRow({ "标题", "开始", "结束", "状态" });
+    writer.writeQuery(q);
+    q.finish();
+    r.ok = writer.close(&r.error);
+    audit(user.username, r);
+    return r;
+}
+
+ActionResult CampusCore::exportEnrollments(const UserInfo &user, const QString &path)
+{
+    if (user.role == "student") return rejectedAction("export_enrollments", tr("仅管理员/发起人可导出报名列表"));
+    ActionResult r;
+    r.action = "export_enrollments";
+    r.target = path;
+    CsvWriter writer;
+    if (!writer.open(path, &r.error)) return r;
+    // 报名记录可能有数十万行，逐行从游标写出
+    const StatementLease stmt = prepared(R"(SELECT a.title, e.student, e.status, e.position
+              FROM enrollments e
+              JOIN activities a ON e.activity_id=a.id
+              ORDER BY a.title, e.status)");
+    QSqlQuery &q = stmt.query();
+    q.setForwardOnly(true);
+    if (!q.exec()) {
+        r.error = q.lastError().text();
+        writer.close();
+        QFile::remove(path);
+        return r;
+    }
+    writer.writeRow({ "活动", "学生", "状态", "候补序号" });
+    writer.writeQuery(q);
+    q.finish();
+    r.ok = writer.close(&r.error);
+    audit(user.username, r);
+    return r;
+}
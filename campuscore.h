@@ -0,0 +1,157 @@
+#pragma once
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QList>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStringList>
+#include "dbmanager.h"
+#include "enrollmentengine.h"
+#include "models/pagedtablemodel.h"
+#include "models/rowtablemodel.h"
+
+struct ActivityFilter {
+    QString role;
+    QString username;
+    QString category;
+    QString status;
+    QString keyword;
+
+    bool operator==(const ActivityFilter &o) const
+    {
+        return role == o.role && username == o.username && category == o.category
+                && status == o.status && keyword == o.keyword;
+    }
+    bool operator!=(const ActivityFilter &o) const { return !(*this == o); }
+};
+
+// 审计日志查询条件：时间范围必填，操作人/操作为空表示不限
+struct AuditFilter {
+    QString actor;
+    QString action;
+    QDateTime from;
+    QDateTime to;
+};
+
+struct ActivityDraft {
+    int id { -1 }; // -1 表示新建
+    QString title;
+    QString category;
+    QString location;
+    QString startTime; // ISO
+    QString endTime;   // ISO
+    int capacity { 0 };
+    QString creator;   // 由 CampusCore 按操作人填写
+};
+
+struct ActionResult {
+    bool ok { false };
+    bool rejected { false }; // 权限或输入校验未通过，未访问数据库
+    QString action; // activity_submit / activity_approve / activity_reject / activity_delete / export_*
+    int id { -1 };
+    QString target; // 审计日志目标
+    QString detail; // 审计日志附加信息
+    QString error;
+};
+Q_DECLARE_METATYPE(ActionResult)
+
+struct LoginResult {
+    enum Outcome { LoggedIn, MissingInput, BadCredentials, RoleMismatch, Failed };
+    Outcome outcome { Failed };
+    UserInfo user;
+    QString error;
+};
+
+struct DashboardStats {
+    quint64 version { 0 }; // 每次内容变化递增，界面可据此跳过重复刷新
+    int totalActivities { 0 };
+    int activeEnrollments { 0 };
+    int approved { 0 };
+    int pending { 0 };
+    QueryRows topActivities;
+};
+Q_DECLARE_METATYPE(DashboardStats)
+
+// 业务核心：账户、活动、报名/候补、统计与审计，只依赖 Qt Core/Sql，不含任何界面代码。
+// 所有方法同步执行并返回结果结构；权限与输入校验在这里完成，成功的写操作在这里记审计日志，
+// 界面、DataService 与无界面进程（工具、服务端）共用同一套规则。
+// 非线程安全：实例绑定创建它的线程，在首次访问时借用该线程的池化连接，析构时归还。
+class CampusCore
+{
+    Q_DECLARE_TR_FUNCTIONS(CampusCore)
+public:
+    CampusCore();
+    ~CampusCore();
+    Q_DISABLE_COPY(CampusCore)
+
+    // 打开并初始化库（设定连接池路径）；失败时返回错误且不动库文件，仅在确认损坏时改名为 *.corrupt-<时间> 后重建
+    bool open(const QString &path, QString *error = nullptr);
+
+    // 账户（需先 open）
+    LoginResult login(const QString &username, const QString &password, const QString &role);
+    ActionResult registerUser(const QString &username, const QString &password, const QString &role);
+
+    // 活动列表：由筛选条件构造分页查询，再按页读取；patch 按 ID 读回变化的行
+    PageQuery activityPageQuery(const ActivityFilter &filter);
+    PageResult fetchPage(const PageRequest &request);
+    RowPatch activityRows(const ActivityFilter &filter, const QList<int> &ids);
+    // 审计日志按 created_at, id 倒序分页；构造前先落库队列中的条目
+    PageQuery auditPageQuery(const AuditFilter &filter);
+
+    QueryRows upcoming();
+    QueryRows availableActivities();
+    RowPatch availableActivityRows(const QList<int> &ids);
+    QueryRows myEnrollments(const QString &student);
+    RowPatch myEnrollmentRows(const QString &student, const QList<int> &ids);
+    // 学生已报名活动之间的时间冲突描述，按开始时间排列
+    QStringList studentConflicts(const QString &student, QString *error = nullptr);
+
+    // 返回缓存的统计快照，只重算自上次以来被写操作标脏的部分
+    DashboardStats stats();
+
+    // 活动：发起人新建/编辑，管理员审批/驳回/删除
+    ActionResult saveActivity(const UserInfo &user, ActivityDraft draft);
+    ActionResult approveActivity(const UserInfo &user, int activityId);
+    ActionResult rejectActivity(const UserInfo &user, int activityId);
+    ActionResult deleteActivity(const UserInfo &user, int activityId);
+
+    // 报名：仅学生本人；成功后同步更新统计快照
+    bool warmStudent(const QString &student, QString *error = nullptr);
+    EnrollResult enroll(const UserInfo &user, int activityId);
+    EnrollResult waitlist(const UserInfo &user, int activityId);
+    CancelResult cancelEnrollment(const UserInfo &user, int enrollmentId);
+
+    // 导出：学生导出自己的报名，管理员/发起人导出全部报名
+    ActionResult exportMyEnrollments(const UserInfo &user, const QString &path);
+    ActionResult exportEnrollments(const UserInfo &user, const QString &path);
+
+private:
+    QSqlDatabase database();
+    // 借出期间持有语句，离开作用域时 finish()
+    StatementLease prepared(const QString &sql);
+    EnrollmentEngine *engine();
+    bool ftsAvailable();
+    void audit(const QString &actor, const ActionResult &r);
+    ActionResult setActivityStatus(const UserInfo &user, int activityId, const QString &status);
+
+    void loadTopActivities();
+    // 报名变化对统计的增量：已报名总数直接加减，前十名能就地调整时不重查
+    void applyEnrollmentStats(int activityId, int activeDelta, int enrolledCount);
+    // 活动增删改可能改变计数与前十名
+    void invalidateActivity(int activityId);
+
+    // 统计快照：活动增删改标脏全部，报名变化只影响报名总数与前十名
+    enum StatsPart { StatsCounts = 0x1, StatsTop = 0x2, StatsAll = StatsCounts | StatsTop };
+    DashboardStats m_stats;
+    QList<int> m_topIds; // 与 m_stats.topActivities 行一一对应
+    int m_statsDirty { StatsAll };
+    qint64 m_statsDataVersion { -1 }; // 上次读取统计时的 PRAGMA data_version
+
+    DbManager m_db;       // open() 后持有连接并负责初始化/账户
+    QSqlDatabase m_conn;  // 未 open 时从连接池借出
+    bool m_leased { false };
+    QSqlQuery m_invalidQuery;
+    EnrollmentEngine *m_engine { nullptr };
+    int m_ftsAvailable { -1 }; // -1 未检测
+};
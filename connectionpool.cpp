@@ -0,0 +1,232 @@
+#include "connectionpool.h"
+#include "dbmanager.h"
+#include "statementcache.h"
+
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QMutexLocker>
+#include <QSettings>
+#include <QSqlError>
+#include <QThread>
+
+ConnectionPool &ConnectionPool::instance()
+{
+    static ConnectionPool pool;
+    return pool;
+}
+
+ConnectionPool::ConnectionPool()
+{
+    m_stats.maxConnections = 8;
+}
+
+void ConnectionPool::setDatabasePath(const QString &path)
+{
+    const int maxConnections = qMax(1, QSettings().value("database/pool_size", 8).toInt());
+    QMutexLocker locker(&m_mutex);
+    m_path = path;
+    m_stats.maxConnections = maxConnections;
+}
+
+void ConnectionPool::setMaxConnections(int count)
+{
+    QMutexLocker locker(&m_mutex);
+    m_stats.maxConnections = qMax(1, count);
+    m_freed.wakeAll();
+}
+
+QString ConnectionPool::databasePath() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_path;
+}
+
+QSqlDatabase ConnectionPool::acquire(QString *error, int timeoutMs)
+{
+    QThread *thread = QThread::currentThread();
+    QMutexLocker locker(&m_mutex);
+    ++m_stats.leases;
+
+    auto it = m_slots.find(thread);
+    if (it != m_slots.end()) {
+        if (it->path == m_path || it->leases > 0) {
+            if (it->path != m_path) {
+                qWarning() << "ConnectionPool: database path changed while" << it->name << "is leased";
+            }
+            ++it->leases;
+            const QString name = it->name;
+            locker.unlock();
+            return QSqlDatabase::database(name, false);
+        }
+        // 空闲连接指向旧文件，关闭后按新路径重开
+        locker.unlock();
+        closeSlot(thread);
+        locker.relock();
+    }
+
+    if (m_stats.openCount >= m_stats.maxConnections) {
+        ++m_stats.waits;
+        ++m_waiting;
+        requestIdleClose(thread);
+        QDeadlineTimer deadline(timeoutMs);
+        while (m_stats.openCount >= m_stats.maxConnections) {
+            if (!m_freed.wait(&m_mutex, deadline)) break;
+        }
+        --m_waiting;
+        if (m_stats.openCount >= m_stats.maxConnections) {
+            if (error) *error = QStringLiteral("连接池已满（%1）").arg(m_stats.maxConnections);
+            return QSqlDatabase();
+        }
+    }
+
+    // 先占名额再在锁外打开，避免打开文件时阻塞其他线程
+    Slot slot;
+    slot.name = QStringLiteral("pool-%1").arg(++m_stats.opened);
+    slot.path = m_path;
+    slot.leases = 1;
+    m_slots.insert(thread, slot);
+    ++m_stats.openCount;
+    m_stats.peakOpen = qMax(m_stats.peakOpen, m_stats.openCount);
+    locker.unlock();
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", slot.name);
+    db.setDatabaseName(slot.path);
+    if (!db.open()) {
+        if (error) *error = db.lastError().text();
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(slot.name);
+        locker.relock();
+        m_slots.remove(thread);
+        --m_stats.openCount;
+        m_freed.wakeOne();
+        return QSqlDatabase();
+    }
+    qInfo().noquote() << DbManager::configureConnection(db, DbTuning::fromSettings());
+    auto *cache = new StatementCache(db);
+    auto *owner = new QObject; // 在本线程创建，关闭请求经它排队回到本线程执行
+
+    // 线程结束时在该线程内关闭其连接（QSqlDatabase 不能跨线程关闭）
+    locker.relock();
+    m_slots[thread].cache = cache;
+    m_slots[thread].owner = owner;
+    if (!m_watched.contains(thread)) {
+        m_watched.insert(thread);
+        QObject::connect(thread, &QThread::finished, thread, [this, thread]() {
+            onThreadFinished(thread);
+        }, Qt::DirectConnection);
+    }
+    return db;
+}
+
+void ConnectionPool::release(bool closeIdle)
+{
+    QThread *thread = QThread::currentThread();
+    QMutexLocker locker(&m_mutex);
+    auto it = m_slots.find(thread);
+    if (it == m_slots.end() || it->leases == 0) return;
+    if (--it->leases > 0) return;
+    // 空闲连接留给本线程复用；线程已结束、有其他线程等待名额或名额已用满时关闭。
+    // 线程池线程空闲时既不结束也不再调用 release，不能指望之后再归还
+    if (!closeIdle && !it->threadFinished && m_waiting == 0 && !it->closeRequested
+            && m_stats.openCount < m_stats.maxConnections) {
+        return;
+    }
+    locker.unlock();
+    closeSlot(thread);
+}
+
+void ConnectionPool::onThreadFinished(QThread *thread)
+{
+    QMutexLocker locker(&m_mutex);
+    m_watched.remove(thread);
+    auto it = m_slots.find(thread);
+    if (it == m_slots.end()) return;
+    if (it->leases > 0) {
+        // 持有者（如随线程一起销毁的 worker）稍后 release 时再关闭
+        it->threadFinished = true;
+        return;
+    }
+    locker.unlock();
+    closeSlot(thread);
+}
+
+void ConnectionPool::closeSlot(QThread *thread)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_slots.find(thread);
+    if (it == m_slots.end()) return;
+    const QString name = it->name;
+    StatementCache *cache = it->cache;
+    QObject *owner = it->owner;
+    if (cache) {
+        m_stats.statementHits += cache->hits();
+        m_stats.statementMisses += cache->misses();
+        m_stats.statementEvictions += cache->evictions();
+    }
+    m_slots.erase(it);
+    --m_stats.openCount;
+    locker.unlock();
+
+    // 语句必须先于连接销毁；owner 与连接同属本线程，未处理的关闭请求随之丢弃
+    delete cache;
+    delete owner;
+    QSqlDatabase::removeDatabase(name);
+    m_freed.wakeOne();
+}
+
+void ConnectionPool::requestIdleClose(QThread *self)
+{
+    for (auto it = m_slots.begin(); it != m_slots.end(); ++it) {
+        if (it.key() == self || it->leases > 0 || it->closeRequested || !it->owner) continue;
+        it->closeRequested = true;
+        // 没有事件循环的线程收不到请求，只能等它结束或下次 release
+        QMetaObject::invokeMethod(it->owner, [this]() { closeIfIdle(); }, Qt::QueuedConnection);
+    }
+}
+
+void ConnectionPool::closeIfIdle()
+{
+    QThread *thread = QThread::currentThread();
+    QMutexLocker locker(&m_mutex);
+    auto it = m_slots.find(thread);
+    if (it == m_slots.end()) return;
+    if (it->leases > 0) {
+        // 请求发出后又被借用，交给下次 release 按等待情况处理
+        it->closeRequested = false;
+        return;
+    }
+    locker.unlock();
+    closeSlot(thread);
+}
+
+StatementCache *ConnectionPool::statements()
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_slots.constFind(QThread::currentThread());
+    return it == m_slots.constEnd() ? nullptr : it->cache;
+}
+
+PoolStats ConnectionPool::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    PoolStats stats = m_stats;
+    for (const Slot &slot : m_slots) {
+        if (!slot.cache) continue;
+        stats.statementHits += slot.cache->hits();
+        stats.statementMisses += slot.cache->misses();
+        stats.statementEvictions += slot.cache->evictions();
+    }
+    return stats;
+}
+
+ConnectionLease::ConnectionLease()
+{
+    m_db = ConnectionPool::instance().acquire(&m_error);
+}
+
+ConnectionLease::~ConnectionLease()
+{
+    const bool leased = m_db.isValid();
+    m_db = QSqlDatabase();
+    if (leased) ConnectionPool::instance().release();
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QString>
+#include <QWaitCondition>
+
+class QThread;
+class StatementCache;
+
+struct PoolStats {
+    quint64 leases { 0 };   // acquire 次数
+    quint64 waits { 0 };    // 因连接数达到上限而等待的次数
+    quint64 opened { 0 };   // 累计新建连接数
+    int openCount { 0 };    // 当前打开的连接数
+    int peakOpen { 0 };
+    int maxConnections { 0 };
+    quint64 statementHits { 0 };   // 预编译语句缓存命中
+    quint64 statementMisses { 0 };
+    quint64 statementEvictions { 0 }; // 超出缓存上限被淘汰的语句
+};
+
+// 每线程一个可复用连接的连接池。
+// 同一线程多次 acquire 共享同一连接（引用计数），连接打开时统一应用 DbTuning；
+// 引用归零后连接保持打开供该线程下次复用，线程结束、有其他线程在等待或名额已用满时才关闭。
+// 名额用满时 acquire 通知持有空闲连接的线程自行关闭（需该线程有事件循环），再等待名额。
+// QSqlDatabase 只能在创建它的线程使用，因此连接不会跨线程借出，也只在属主线程关闭。
+class ConnectionPool
+{
+public:
+    static ConnectionPool &instance();
+
+    // 设置数据库文件与最大连接数（database/pool_size，默认 8）
+    void setDatabasePath(const QString &path);
+    QString databasePath() const;
+    // 覆盖 database/pool_size（需在 setDatabasePath 之后调用，如压测工具按线程数放宽上限）
+    void setMaxConnections(int count);
+
+    // 为当前线程借出连接；达到上限时最多等待 timeoutMs，失败返回无效连接
+    QSqlDatabase acquire(QString *error = nullptr, int timeoutMs = 5000);
+    // 归还当前线程的一次借用；调用前需释放所有基于该连接的 QSqlQuery/QSqlDatabase 副本。
+    // closeIdle 为 true 时若已无借用则立即关闭连接（如需删除/重建库文件）
+    void release(bool closeIdle = false);
+    // 当前线程连接上的预编译语句缓存；当前线程未借出连接时返回 nullptr
+    StatementCache *statements();
+
+    PoolStats stats() const;
+
+private:
+    ConnectionPool();
+    Q_DISABLE_COPY(ConnectionPool)
+
+    struct Slot {
+        QString name;
+        QString path;
+        int leases { 0 };
+        bool threadFinished { false };
+        bool closeRequested { false };
+        StatementCache *cache { nullptr };
+        QObject *owner { nullptr }; // 属于连接所在线程，用于把关闭请求投递到该线程
+    };
+
+    void closeSlot(QThread *thread);
+    // 需持有 m_mutex：请其他线程关闭各自的空闲连接
+    void requestIdleClose(QThread *self);
+    // 在属主线程执行：连接仍空闲时关闭
+    void closeIfIdle();
+    void onThreadFinished(QThread *thread);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_freed;
+    QHash<QThread *, Slot> m_slots;
+    QSet<QThread *> m_watched;
+    QString m_path;
+    int m_waiting { 0 };
+    PoolStats m_stats;
+};
+
+// RAII 借用：析构时自动归还
+class ConnectionLease
+{
+public:
+    ConnectionLease();
+    ~ConnectionLease();
+    QSqlDatabase database() const { return m_db; }
+    bool isValid() const { return m_db.isOpen(); }
+    QString errorText() const { return m_error; }
+
+private:
+    Q_DISABLE_COPY(ConnectionLease)
+    QSqlDatabase m_db;
+    QString m_error;
+};
@@ -0,0 +1,194 @@
+#include "dataservice.h"
+
+#include <QDebug>
+#include <QMetaObject>
+
+DataService::DataService(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<QueryRows>("QueryRows");
+    qRegisterMetaType<RowPatch>("RowPatch");
+    qRegisterMetaType<PageQuery>("PageQuery");
+    qRegisterMetaType<PageRequest>("PageRequest");
+    qRegisterMetaType<PageResult>("PageResult");
+    qRegisterMetaType<EnrollResult>("EnrollResult");
+    qRegisterMetaType<CancelResult>("CancelResult");
+    qRegisterMetaType<ActionResult>("ActionResult");
+    qRegisterMetaType<DashboardStats>("DashboardStats");
+}
+
+DataService::~DataService()
+{
+    // 在服务线程内析构，CampusCore 在此归还本线程的连接
+    delete m_core;
+    m_core = nullptr;
+}
+
+CampusCore *DataService::core()
+{
+    // 首次使用时在服务线程创建，连接与预编译语句都绑定在该线程
+    if (!m_core) m_core = new CampusCore;
+    return m_core;
+}
+
+template <typename Fn>
+void DataService::post(Fn fn)
+{
+    // 投递到服务所在线程执行，调用方立即返回
+    QMetaObject::invokeMethod(this, fn, Qt::QueuedConnection);
+}
+
+void DataService::loadActivities(const ActivityFilter &filter)
+{
+    // 序号在调用方线程递增，服务线程据此识别已被取代的请求
+    const quint64 generation = ++m_activityGeneration;
+    post([this, filter, generation]() {
+        if (m_activityGeneration.loadRelaxed() != generation) return;
+        m_activitiesLoaded = true;
+        m_activityFilter = filter;
+        emit activityQueryReady(core()->activityPageQuery(filter));
+    });
+}
+
+void DataService::fetchPage(const PageRequest &request)
+{
+    post([this, request]() { emit pageLoaded(core()->fetchPage(request)); });
+}
+
+void DataService::loadAuditLog(const AuditFilter &filter)
+{
+    post([this, filter]() { emit auditQueryReady(core()->auditPageQuery(filter)); });
+}
+
+void DataService::loadUpcoming()
+{
+    post([this]() { emit upcomingLoaded(core()->upcoming()); });
+}
+
+void DataService::loadAvailableActivities()
+{
+    post([this]() {
+        m_availableLoaded = true;
+        emit availableActivitiesLoaded(core()->availableActivities());
+    });
+}
+
+void DataService::loadMyEnrollments(const QString &student)
+{
+    post([this, student]() {
+        m_enrollmentStudent = student;
+        emit myEnrollmentsLoaded(core()->myEnrollments(student));
+    });
+}
+
+void DataService::loadStats()
+{
+    post([this]() { emit statsLoaded(core()->stats()); });
+}
+
+void DataService::checkStudentConflicts(const QString &student)
+{
+    post([this, student]() {
+        QString err;
+        const QStringList conflicts = core()->studentConflicts(student, &err);
+        emit studentConflictsLoaded(conflicts, err);
+    });
+}
+
+void DataService::warmStudent(const QString &student)
+{
+    post([this, student]() {
+        QString err;
+        if (!core()->warmStudent(student, &err)) {
+            qWarning() << "DataService: failed to load intervals for" << student << err;
+        }
+    });
+}
+
+void DataService::enroll(int activityId, const UserInfo &user)
+{
+    post([this, activityId, user]() {
+        const EnrollResult r = core()->enroll(user, activityId);
+        emit enrollFinished(r);
+        if (r.outcome == EnrollResult::Enrolled || r.outcome == EnrollResult::Waitlisted) {
+            publishEnrollmentChange(activityId, { r.enrollmentId });
+        }
+    });
+}
+
+void DataService::waitlist(int activityId, const UserInfo &user)
+{
+    post([this, activityId, user]() {
+        const EnrollResult r = core()->waitlist(user, activityId);
+        emit waitlistFinished(r);
+        if (r.outcome == EnrollResult::Enrolled || r.outcome == EnrollResult::Waitlisted) {
+            publishEnrollmentChange(activityId, { r.enrollmentId });
+        }
+    });
+}
+
+void DataService::cancelEnrollment(int enrollmentId, const UserInfo &user)
+{
+    post([this, enrollmentId, user]() {
+        const CancelResult r = core()->cancelEnrollment(user, enrollmentId);
+        emit cancelFinished(r);
+        if (!r.ok) return;
+        QList<int> changed { r.enrollmentId };
+        if (r.promotedId >= 0) changed << r.promotedId;
+        publishEnrollmentChange(r.activityId, changed);
+    });
+}
+
+void DataService::saveActivity(const ActivityDraft &draft, const UserInfo &user)
+{
+    post([this, draft, user]() { emitActivityAction(core()->saveActivity(user, draft)); });
+}
+
+void DataService::approveActivity(int activityId, const UserInfo &user)
+{
+    post([this, activityId, user]() { emitActivityAction(core()->approveActivity(user, activityId)); });
+}
+
+void DataService::rejectActivity(int activityId, const UserInfo &user)
+{
+    post([this, activityId, user]() { emitActivityAction(core()->rejectActivity(user, activityId)); });
+}
+
+void DataService::deleteActivity(int activityId, const UserInfo &user)
+{
+    post([this, activityId, user]() { emitActivityAction(core()->deleteActivity(user, activityId)); });
+}
+
+void DataService::exportMyEnrollments(const QString &path, const UserInfo &user)
+{
+    post([this, path, user]() { emit exportFinished(core()->exportMyEnrollments(user, path)); });
+}
+
+void DataService::exportEnrollments(const QString &path, const UserInfo &user)
+{
+    post([this, path, user]() { emit exportFinished(core()->exportEnrollments(user, path)); });
+}
+
+void DataService::emitActivityAction(const ActionResult &result)
+{
+    emit activityActionFinished(result);
+    if (result.ok) publishActivityChange(result.id);
+}
+
+void DataService::publishActivityChange(int activityId)
+{
+    if (m_activitiesLoaded) emit activitiesPatched(core()->activityRows(m_activityFilter, { activityId }));
+    if (m_availableLoaded) emit availableActivitiesPatched(core()->availableActivityRows({ activityId }));
+    // 近期活动是 LIMIT 20 的窗口，单行变化可能移入移出，直接重查（仅 20 行）
+    emit upcomingLoaded(core()->upcoming());
+}
+
+void DataService::publishEnrollmentChange(int activityId, const QList<int> &enrollmentIds)
+{
+    if (m_availableLoaded && activityId >= 0) {
+        emit availableActivitiesPatched(core()->availableActivityRows({ activityId }));
+    }
+    if (!m_enrollmentStudent.isEmpty()) {
+        emit myEnrollmentsPatched(core()->myEnrollmentRows(m_enrollmentStudent, enrollmentIds));
+    }
+}
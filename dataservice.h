@@ -0,0 +1,84 @@
+#pragma once
+
+#include <QAtomicInteger>
+#include <QObject>
+#include "campuscore.h"
+
+// 数据访问服务：CampusCore 的异步外壳，运行在独立线程，持有该线程的 CampusCore 实例。
+// 公共方法可在任意线程调用，只是把请求投递到服务线程，结果通过信号返回；
+// 权限、校验、统计与审计都在 CampusCore 中完成。
+// 每次写操作成功后按受影响的活动/报名 ID 重新查询这些行，以 *Patched 信号送出增量，
+// 视图只更新变化的行，无需整表重载。
+class DataService : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DataService(QObject *parent = nullptr);
+    ~DataService();
+
+    // 活动列表按页加载：先由筛选条件构造分页查询（activityQueryReady），
+    // 模型再按需 fetchPage。新请求会取代尚未完成的旧请求，被取代的请求不发出结果
+    void loadActivities(const ActivityFilter &filter);
+    void fetchPage(const PageRequest &request);
+    // 审计日志同样按页加载（按 created_at, id 倒序 keyset 翻页），先落库队列中的条目再构造查询
+    void loadAuditLog(const AuditFilter &filter);
+    void loadUpcoming();
+    void loadAvailableActivities();
+    void loadMyEnrollments(const QString &student);
+    // 返回缓存的统计快照，只重算自上次以来被写操作标脏的部分
+    void loadStats();
+    // 学生已报名活动之间的时间冲突（studentConflictsLoaded）
+    void checkStudentConflicts(const QString &student);
+    // 预热学生的报名区间索引（登录时调用），使首次报名的冲突检查不再查库
+    void warmStudent(const QString &student);
+
+    void enroll(int activityId, const UserInfo &user);
+    void waitlist(int activityId, const UserInfo &user);
+    void cancelEnrollment(int enrollmentId, const UserInfo &user);
+
+    void saveActivity(const ActivityDraft &draft, const UserInfo &user);
+    void approveActivity(int activityId, const UserInfo &user);
+    void rejectActivity(int activityId, const UserInfo &user);
+    void deleteActivity(int activityId, const UserInfo &user);
+
+    // 导出在服务线程逐行从游标写出，完成后发出 exportFinished
+    void exportMyEnrollments(const QString &path, const UserInfo &user);
+    void exportEnrollments(const QString &path, const UserInfo &user);
+
+signals:
+    void activityQueryReady(const PageQuery &query);
+    void pageLoaded(const PageResult &result);
+    void auditQueryReady(const PageQuery &query);
+    void upcomingLoaded(const QueryRows &rows);
+    void availableActivitiesLoaded(const QueryRows &rows);
+    void myEnrollmentsLoaded(const QueryRows &rows);
+    void activitiesPatched(const RowPatch &patch);
+    void availableActivitiesPatched(const RowPatch &patch);
+    void myEnrollmentsPatched(const RowPatch &patch);
+    void statsLoaded(const DashboardStats &stats);
+    void studentConflictsLoaded(const QStringList &conflicts, const QString &error);
+
+    void enrollFinished(const EnrollResult &result);
+    void waitlistFinished(const EnrollResult &result);
+    void cancelFinished(const CancelResult &result);
+    void activityActionFinished(const ActionResult &result);
+    void exportFinished(const ActionResult &result);
+
+private:
+    CampusCore *core();
+    template <typename Fn> void post(Fn fn);
+
+    void emitActivityAction(const ActionResult &result);
+    // 写操作之后向已加载的列表推送增量
+    void publishActivityChange(int activityId);
+    void publishEnrollmentChange(int activityId, const QList<int> &enrollmentIds);
+
+    CampusCore *m_core { nullptr };
+
+    // 最近一次加载的条件，增量查询沿用同样的条件；未加载过的列表不推送增量
+    QAtomicInteger<quint64> m_activityGeneration { 0 };
+    bool m_activitiesLoaded { false };
+    ActivityFilter m_activityFilter;
+    bool m_availableLoaded { false };
+    QString m_enrollmentStudent;
+};
@@ -1,10 +1,17 @@
 #include "dbmanager.h"
+#include "connectionpool.h"
+#include "enrollmentengine.h"
+#include "statementcache.h"
 
 #include <QDir>
 #include <QDateTime>
+#include <QTimeZone>
 #include <QSqlRecord>
 #include <QDebug>
-#include <QRandomGenerator>
+#include <QStringList>
+#include <QStandardPaths>
+#include <QPair>
+#include <QSettings>
 
 namespace {
 QString createUsersTable()
@@ -66,6 +73,43 @@ QString createAuditLogsTable()
     )SQL");
 }
 
+// 维护 activities.enrolled_count / waiting_count，报名表任何状态变化都在同一事务内同步计数
+QStringList counterTriggers()
+{
+    return {
+        QStringLiteral(R"SQL(
+            CREATE TRIGGER IF NOT EXISTS trg_enrollments_count_insert AFTER INSERT ON enrollments
+            BEGIN
+                UPDATE activities SET enrolled_count = enrolled_count + (NEW.status='active'),
+                                      waiting_count = waiting_count + (NEW.status='waiting')
+                WHERE id = NEW.activity_id;
+            END
+        )SQL"),
+        QStringLiteral(R"SQL(
+            CREATE TRIGGER IF NOT EXISTS trg_enrollments_count_update AFTER UPDATE OF status, activity_id ON enrollments
+            BEGIN
+                UPDATE activities SET enrolled_count = enrolled_count - (OLD.status='active'),
+                                      waiting_count = waiting_count - (OLD.status='waiting')
+                WHERE id = OLD.activity_id;
+                UPDATE activities SET enrolled_count = enrolled_count + (NEW.status='active'),
+                                      waiting_count = waiting_count + (NEW.status='waiting')
+                WHERE id = NEW.activity_id;
+            END
+        )SQL"),
+        QStringLiteral(R"SQL(
+            CREATE TRIGGER IF NOT EXISTS trg_enrollments_count_delete AFTER DELETE ON enrollments
+            BEGIN
+                UPDATE activities SET enrolled_count = enrolled_count - (OLD.status='active'),
+                                      waiting_count = waiting_count - (OLD.status='waiting')
+                WHERE id = OLD.activity_id;
+            END
+        )SQL")
+    };
+}
+
+const char *kActiveCount = "(SELECT COUNT(*) FROM enrollments e WHERE e.activity_id=activities.id AND e.status='active')";
+const char *kWaitingCount = "(SELECT COUNT(*) FROM enrollments e WHERE e.activity_id=activities.id AND e.status='waiting')";
+
 }
 
 DbManager::DbManager(QObject *parent)
@@ -75,27 +119,101 @@ DbManager::DbManager(QObject *parent)
 
 DbManager::~DbManager()
 {
-    if (m_db.isOpen()) {
-        m_db.close();
-    }
-    // 不在析构时 removeDatabase，避免仍有引用导致崩溃
+    close();
 }
 
 bool DbManager::open(const QString &path)
 {
-    // 每次打开使用独立连接名，避免与其他窗口/线程冲突
-    m_connName = QStringLiteral("conn-%1").arg(QRandomGenerator::global()->generate64());
-    m_db = QSqlDatabase::addDatabase("QSQLITE", m_connName);
-    m_db.setDatabaseName(path);
-
-    if (!m_db.open()) {
-        m_lastError = m_db.lastError().text();
+    // 连接来自连接池：同一线程内的所有 DbManager 共享一个已调优的连接，登出/登录不再新建
+    close();
+    ConnectionPool &pool = ConnectionPool::instance();
+    pool.setDatabasePath(path);
+    m_db = pool.acquire(&m_lastError);
+    if (!m_db.isValid()) {
         emit error(tr("Failed to open database: %1").arg(m_lastError));
         return false;
     }
+    m_leased = true;
     return true;
 }
 
+void DbManager::close(bool discard)
+{
+    if (!m_leased) return;
+    m_uncached = QSqlQuery();
+    m_db = QSqlDatabase();
+    m_leased = false;
+    ConnectionPool::instance().release(discard);
+}
+
+DbTuning DbTuning::preset(const QString &name)
+{
+    DbTuning t;
+    if (name == "legacy") {
+        // SQLite 默认行为：回滚日志 + 完全同步
+        t.name = "legacy";
+        t.journalMode = "DELETE";
+        t.synchronous = "FULL";
+        t.mmapSize = 0;
+        t.cacheSizeKb = 2000;
+        t.tempStore = "DEFAULT";
+    } else if (name == "safe") {
+        // WAL 读写互不阻塞，但每次提交仍 fsync
+        t.name = "safe";
+        t.journalMode = "WAL";
+        t.synchronous = "FULL";
+        t.mmapSize = 64LL * 1024 * 1024;
+        t.cacheSizeKb = 16 * 1024;
+        t.tempStore = "MEMORY";
+    } else {
+        // WAL 下 NORMAL 只在 checkpoint 时 fsync，断电最多丢失最后的提交，库不会损坏
+        t.name = "performance";
+        t.journalMode = "WAL";
+        t.synchronous = "NORMAL";
+        t.mmapSize = 256LL * 1024 * 1024;
+        t.cacheSizeKb = 64 * 1024;
+        t.tempStore = "MEMORY";
+    }
+    return t;
+}
+
+DbTuning DbTuning::fromSettings()
+{
+    QSettings settings;
+    DbTuning t = preset(settings.value("database/profile", "performance").toString());
+    t.journalMode = settings.value("database/journal_mode", t.journalMode).toString();
+    t.synchronous = settings.value("database/synchronous", t.synchronous).toString();
+    t.mmapSize = settings.value("database/mmap_size", t.mmapSize).toLongLong();
+    t.cacheSizeKb = settings.value("database/cache_size_kb", t.cacheSizeKb).toInt();
+    t.busyTimeoutMs = settings.value("database/busy_timeout_ms", t.busyTimeoutMs).toInt();
+    t.tempStore = settings.value("database/temp_store", t.tempStore).toString();
+    return t;
+}
+
+QString DbManager::configureConnection(QSqlDatabase &db, const DbTuning &tuning)
+{
+    QSqlQuery q(db);
+    // busy_timeout 先行，后续切换 WAL 时如遇锁可等待
+    q.exec(QString("PRAGMA busy_timeout = %1").arg(tuning.busyTimeoutMs));
+    q.exec(QString("PRAGMA journal_mode = %1").arg(tuning.journalMode));
+    q.exec(QString("PRAGMA synchronous = %1").arg(tuning.synchronous));
+    q.exec(QString("PRAGMA mmap_size = %1").arg(tuning.mmapSize));
+    // 负值表示以 KiB 为单位
+    q.exec(QString("PRAGMA cache_size = -%1").arg(tuning.cacheSizeKb));
+    q.exec(QString("PRAGMA temp_store = %1").arg(tuning.tempStore));
+
+    QStringList effective;
+    for (const char *pragma : { "journal_mode", "synchronous", "mmap_size", "cache_size", "busy_timeout", "temp_store" }) {
+        const QString name = QString::fromLatin1(pragma);
+        if (q.exec("PRAGMA " + name) && q.next()) {
+            effective << QString("%1=%2").arg(name, q.value(0).toString());
+        }
+    }
+    q.finish();
+    return QString("SQLite profile '%1' on %2: %3")
+            .arg(tuning.name, db.connectionName(), effective.join(' '));
+}
+
 bool DbManager::initSchema()
 {
     QSqlQuery q(m_db);
@@ -119,23 +237,395 @@ bool DbManager::initSchema()
         emit error(m_lastError);
         return false;
     }
-    // 单独执行索引创建，避免一次多语句
-    if (!q.exec("CREATE INDEX IF NOT EXISTS idx_enrollment_activity ON enrollments(activity_id)")) {
+    // 单独执行索引创建，避免一次多语句；报名表索引由迁移维护
+    if (!q.exec("CREATE INDEX IF NOT EXISTS idx_audit_time ON audit_logs(created_at)")) {
         m_lastError = q.lastError().text();
         emit error(m_lastError);
         return false;
     }
-    if (!q.exec("CREATE INDEX IF NOT EXISTS idx_enrollment_student ON enrollments(student)")) {
-        m_lastError = q.lastError().text();
+    if (!migrate()) {
+        return false;
+    }
+    if (!ensureActivitySearch()) {
+        return false;
+    }
+    return ensureSampleData();
+}
+
+int DbManager::schemaVersion()
+{
+    QSqlQuery q(m_db);
+    if (q.exec("PRAGMA user_version") && q.next()) return q.value(0).toInt();
+    return 0;
+}
+
+bool DbManager::migrate()
+{
+    // 按版本号顺序追加，已发布的条目不要修改；每一步在独立事务中执行并写入 user_version
+    struct Migration {
+        int version;
+        const char *name;
+        bool (DbManager::*apply)();
+    };
+    static const Migration kMigrations[] = {
+        { 1, "activity enrollment counters", &DbManager::ensureCounters },
+        { 2, "composite/partial indexes for hot queries", &DbManager::migrateHotIndexes },
+        { 3, "integer epoch time columns", &DbManager::migrateEpochColumns },
+        { 4, "activity category index", &DbManager::migrateActivitySearch },
+        { 5, "audit actor/action time indexes", &DbManager::migrateAuditIndexes },
+    };
+
+    const int current = schemaVersion();
+    for (const Migration &m : kMigrations) {
+        if (m.version <= current) continue;
+        if (!m_db.transaction()) {
+            m_lastError = m_db.lastError().text();
+            emit error(m_lastError);
+            return false;
+        }
+        QSqlQuery q(m_db);
+        if (!(this->*m.apply)() || !execOrFail(q, QString("PRAGMA user_version = %1").arg(m.version))) {
+            m_db.rollback();
+            qWarning() << "Schema migration failed:" << m.version << m.name << m_lastError;
+            return false;
+        }
+        if (!m_db.commit()) {
+            m_lastError = m_db.lastError().text();
+            emit error(m_lastError);
+            return false;
+        }
+        qInfo() << "Schema migrated to version" << m.version << m.name;
+    }
+    return true;
+}
+
+bool DbManager::migrateHotIndexes()
+{
+    QSqlQuery q(m_db);
+    const QStringList statements {
+        // 单列索引是下面复合索引的前缀，删除以减少写放大
+        "DROP INDEX IF EXISTS idx_enrollment_activity",
+        "DROP INDEX IF EXISTS idx_enrollment_student",
+        // 查重 / 容量 / 候补：activity_id + status
+        "CREATE INDEX IF NOT EXISTS idx_enrollment_activity_status ON enrollments(activity_id, status)",
+        // 我的报名、冲突检测：student + status
+        "CREATE INDEX IF NOT EXISTS idx_enrollment_student_status ON enrollments(student, status)",
+        // 候补队列：只索引 waiting 行，MAX(position) 与队首查询直接走索引
+        "CREATE INDEX IF NOT EXISTS idx_enrollment_waitlist ON enrollments(activity_id, position) WHERE status='waiting'",
+        // 可报名活动：status='approved' ORDER BY start_time
+        "CREATE INDEX IF NOT EXISTS idx_activity_status_start ON activities(status, start_time)",
+        // 首页近期活动：status!='cancelled' ORDER BY start_time LIMIT 20
+        "CREATE INDEX IF NOT EXISTS idx_activity_live_start ON activities(start_time) WHERE status!='cancelled'",
+        // 发起人只看自己的活动
+        "CREATE INDEX IF NOT EXISTS idx_activity_creator ON activities(creator)"
+    };
+    for (const QString &sql : statements) {
+        if (!execOrFail(q, sql)) return false;
+    }
+    return true;
+}
+
+bool DbManager::migrateEpochColumns()
+{
+    // *_ts 为本地时间按 UTC 解释的秒数，与 strftime('%s', <ISO 本地时间>) 一致；
+    // ISO 文本列保留用于显示与导出
+    QSqlQuery q(m_db);
+    if (!hasColumn("activities", "start_ts")
+            && !execOrFail(q, "ALTER TABLE activities ADD COLUMN start_ts INTEGER")) return false;
+    if (!hasColumn("activities", "end_ts")
+            && !execOrFail(q, "ALTER TABLE activities ADD COLUMN end_ts INTEGER")) return false;
+    if (!hasColumn("enrollments", "created_ts")
+            && !execOrFail(q, "ALTER TABLE enrollments ADD COLUMN created_ts INTEGER")) return false;
+
+    const QStringList statements {
+        "UPDATE activities SET start_ts = CAST(strftime('%s', start_time) AS INTEGER),"
+        " end_ts = CAST(strftime('%s', end_time) AS INTEGER)",
+        "UPDATE enrollments SET created_ts = CAST(strftime('%s', created_at) AS INTEGER) WHERE created_ts IS NULL",
+        // 活动写入较少，由触发器从 ISO 文本派生；报名为热点路径，由写入方直接给出 created_ts
+        R"SQL(
+            CREATE TRIGGER IF NOT EXISTS trg_activities_ts_insert AFTER INSERT ON activities
+            BEGIN
+                UPDATE activities SET start_ts = CAST(strftime('%s', NEW.start_time) AS INTEGER),
+                                      end_ts = CAST(strftime('%s', NEW.end_time) AS INTEGER)
+                WHERE id = NEW.id;
+            END
+        )SQL",
+        R"SQL(
+            CREATE TRIGGER IF NOT EXISTS trg_activities_ts_update AFTER UPDATE OF start_time, end_time ON activities
+            BEGIN
+                UPDATE activities SET start_ts = CAST(strftime('%s', NEW.start_time) AS INTEGER),
+                                      end_ts = CAST(strftime('%s', NEW.end_time) AS INTEGER)
+                WHERE id = NEW.id;
+            END
+        )SQL",
+        R"SQL(
+            CREATE TRIGGER IF NOT EXISTS trg_enrollments_ts_insert AFTER INSERT ON enrollments
+            WHEN NEW.created_ts IS NULL
+            BEGIN
+                UPDATE enrollments SET created_ts = CAST(strftime('%s', NEW.created_at) AS INTEGER) WHERE id = NEW.id;
+            END
+        )SQL",
+        // 排序/范围查询改走整数列
+        "DROP INDEX IF EXISTS idx_activity_status_start",
+        "DROP INDEX IF EXISTS idx_activity_live_start",
+        "CREATE INDEX IF NOT EXISTS idx_activity_status_start_ts ON activities(status, start_ts)",
+        "CREATE INDEX IF NOT EXISTS idx_activity_live_start_ts ON activities(start_ts) WHERE status!='cancelled'",
+        "CREATE INDEX IF NOT EXISTS idx_activity_time ON activities(start_ts, end_ts)"
+    };
+    for (const QString &sql : statements) {
+        if (!execOrFail(q, sql)) return false;
+    }
+    return true;
+}
+
+bool DbManager::migrateActivitySearch()
+{
+    QSqlQuery q(m_db);
+    // 分类来自下拉框，按等值筛选；全文索引不随版本号记录，见 ensureActivitySearch
+    return execOrFail(q, "CREATE INDEX IF NOT EXISTS idx_activity_category ON activities(category)");
+}
+
+bool DbManager::ensureActivitySearch()
+{
+    // 每次初始化都检查：当前 SQLite 不支持时不写入任何标记，换用支持的版本后下次启动即补建
+    if (hasActivitySearch(m_db)) return true;
+    if (!m_db.transaction()) {
+        m_lastError = m_db.lastError().text();
         emit error(m_lastError);
         return false;
     }
-    if (!q.exec("CREATE INDEX IF NOT EXISTS idx_audit_time ON audit_logs(created_at)")) {
-        m_lastError = q.lastError().text();
+    QSqlQuery q(m_db);
+    // trigram 分词按字符三元组建索引，中文无需分词器；需 SQLite 3.34+ 且启用 FTS5。
+    // 不支持时保留 LIKE 查询路径，不视为初始化失败
+    if (!q.exec(R"(CREATE VIRTUAL TABLE IF NOT EXISTS activities_fts USING fts5(
+                       title, location, category,
+                       content='activities', content_rowid='id', tokenize='trigram'))")) {
+        qWarning() << "FTS5 trigram unavailable, keyword search falls back to LIKE:" << q.lastError().text();
+        m_db.rollback();
+        return true;
+    }
+    // 外部内容表：由触发器与 activities 保持同步
+    const QStringList statements {
+        R"SQL(
+            CREATE TRIGGER IF NOT EXISTS trg_activities_fts_insert AFTER INSERT ON activities
+            BEGIN
+                INSERT INTO activities_fts(rowid, title, location, category)
+                VALUES (NEW.id, NEW.title, NEW.location, NEW.category);
+            END
+        )SQL",
+        R"SQL(
+            CREATE TRIGGER IF NOT EXISTS trg_activities_fts_delete AFTER DELETE ON activities
+            BEGIN
+                INSERT INTO activities_fts(activities_fts, rowid, title, location, category)
+                VALUES ('delete', OLD.id, OLD.title, OLD.location, OLD.category);
+            END
+        )SQL",
+        R"SQL(
+            CREATE TRIGGER IF NOT EXISTS trg_activities_fts_update AFTER UPDATE OF title, location, category ON activities
+            BEGIN
+                INSERT INTO activities_fts(activities_fts, rowid, title, location, category)
+                VALUES ('delete', OLD.id, OLD.title, OLD.location, OLD.category);
+                INSERT INTO activities_fts(rowid, title, location, category)
+                VALUES (NEW.id, NEW.title, NEW.location, NEW.category);
+            END
+        )SQL",
+        "INSERT INTO activities_fts(activities_fts) VALUES('rebuild')"
+    };
+    for (const QString &sql : statements) {
+        if (!execOrFail(q, sql)) {
+            m_db.rollback();
+            return false;
+        }
+    }
+    if (!m_db.commit()) {
+        m_lastError = m_db.lastError().text();
         emit error(m_lastError);
         return false;
     }
-    return ensureSampleData();
+    qInfo() << "Created FTS5 trigram index activities_fts";
+    return true;
+}
+
+bool DbManager::migrateAuditIndexes()
+{
+    QSqlQuery q(m_db);
+    // 审计查询总是带时间范围并按时间倒序翻页：等值列在前、created_at 在后，
+    // 索引隐含 rowid，(created_at, id) 的 keyset 排序无需额外排序步骤
+    return execOrFail(q, "CREATE INDEX IF NOT EXISTS idx_audit_actor_time ON audit_logs(actor, created_at)")
+            && execOrFail(q, "CREATE INDEX IF NOT EXISTS idx_audit_action_time ON audit_logs(action, created_at)");
+}
+
+bool DbManager::hasActivitySearch(const QSqlDatabase &db)
+{
+    QSqlQuery q(db);
+    return q.exec("SELECT 1 FROM sqlite_master WHERE type='table' AND name='activities_fts'") && q.next();
+}
+
+qint64 DbManager::toEpoch(const QDateTime &local)
+{
+    // 与库中 strftime('%s', <ISO 本地时间>) 同一基准
+    return local.toSecsSinceEpoch() + local.offsetFromUtc();
+}
+
+QString DbManager::formatEpoch(qint64 ts, const QString &format)
+{
+    // *_ts 是按 UTC 解释的本地时间，还原时同样按 UTC 处理
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+    return QDateTime::fromSecsSinceEpoch(ts, QTimeZone::UTC).toString(format);
+#else
+    return QDateTime::fromSecsSinceEpoch(ts, Qt::UTC).toString(format);
+#endif
+}
+
+QStringList DbManager::explainHotQueries()
+{
+    // 报名引擎的语句取自 EnrollmentSql，与引擎实际 prepare 的文本相同；其余为 CampusCore 列表/检索/审计查询的形状
+    const QList<QPair<QString, QString>> queries {
+        { "enroll.duplicate", EnrollmentSql::kDuplicate },
+        { "enroll.activity", EnrollmentSql::kActivity },
+        { "enroll.intervals", EnrollmentSql::kStudentIntervals },
+        { "cancel.enrollment", EnrollmentSql::kEnrollment },
+        { "cancel.nextWaiting", EnrollmentSql::kNextWaiting },
+        { "list.available", R"(SELECT a.id, a.title, a.start_time, a.enrolled_count FROM activities a
+                               WHERE a.status='approved' ORDER BY a.start_ts)" },
+        { "list.upcoming", R"(SELECT title, start_time FROM activities
+                              WHERE status!='cancelled' AND start_ts >= CAST(strftime('%s','now','localtime') AS INTEGER)
+                              ORDER BY start_ts LIMIT 20)" },
+        { "list.mine", R"(SELECT e.id, a.title, e.status FROM enrollments e JOIN activities a ON e.activity_id=a.id
+                          WHERE e.student=? ORDER BY a.start_ts)" },
+        { "list.initiator", "SELECT id, title FROM activities WHERE creator=?" },
+        { "search.keyword", R"(SELECT id, title FROM activities
+                               JOIN (SELECT rowid AS fts_id, rank AS fts_rank FROM activities_fts WHERE activities_fts MATCH ?)
+                               ON fts_id=id ORDER BY fts_rank)" },
+        { "search.category", "SELECT id, title FROM activities WHERE category=?" },
+        { "audit.actor", R"(SELECT id, action, target FROM audit_logs
+                           WHERE actor=? AND created_at BETWEEN ? AND ?
+                           ORDER BY created_at DESC, id DESC LIMIT 200)" },
+        { "audit.action", R"(SELECT id, actor, target FROM audit_logs
+                            WHERE action=? AND created_at BETWEEN ? AND ?
+                            ORDER BY created_at DESC, id DESC LIMIT 200)" },
+        { "student.conflicts", R"(SELECT a1.title, a2.title FROM enrollments e1
+                                 JOIN activities a1 ON e1.activity_id=a1.id
+                                 JOIN enrollments e2 ON e2.student=e1.student AND e2.status='active' AND e2.id!=e1.id
+                                 JOIN activities a2 ON e2.activity_id=a2.id
+                                 WHERE e1.student=? AND e1.status='active'
+                                 AND a2.start_ts < a1.end_ts AND a1.start_ts < a2.end_ts)" },
+    };
+
+    QStringList out;
+    for (const auto &entry : queries) {
+        QSqlQuery q(m_db);
+        if (!q.prepare("EXPLAIN QUERY PLAN " + entry.second)) {
+            out << QString("[%1] ERROR %2").arg(entry.first, q.lastError().text());
+            continue;
+        }
+        // 占位符绑定 NULL 即可，不影响计划选择
+        for (int i = 0; i < entry.second.count('?'); ++i) q.addBindValue(QVariant());
+        if (!q.exec()) {
+            out << QString("[%1] ERROR %2").arg(entry.first, q.lastError().text());
+            continue;
+        }
+        while (q.next()) {
+            const QString detail = q.value(3).toString();
+            // 虚拟表（FTS5）的 SCAN 实际走其自身索引
+            const bool fullScan = detail.startsWith("SCAN") && !detail.contains("USING") && !detail.contains("VIRTUAL TABLE");
+            out << QString("[%1]%2 %3").arg(entry.first, fullScan ? " FULL-SCAN" : "", detail);
+        }
+    }
+    return out;
+}
+
+QString DbManager::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+            + QDir::separator() + "activity.db";
+}
+
+StatementLease DbManager::prepared(const QString &sql)
+{
+    StatementCache *cache = m_leased ? ConnectionPool::instance().statements() : nullptr;
+    if (cache) return cache->prepared(sql);
+    // 未借出连接（打开失败）时退化为一次性语句
+    m_uncached = QSqlQuery(m_db);
+    m_uncached.prepare(sql);
+    return StatementLease(&m_uncached);
+}
+
+bool DbManager::execOrFail(QSqlQuery &q, const QString &sql)
+{
+    if (q.exec(sql)) return true;
+    m_lastError = q.lastError().text();
+    emit error(m_lastError);
+    return false;
+}
+
+bool DbManager::hasColumn(const QString &table, const QString &column)
+{
+    QSqlQuery q(m_db);
+    q.exec(QString("PRAGMA table_info(%1)").arg(table));
+    while (q.next()) {
+        if (q.value(1).toString() == column) return true;
+    }
+    return false;
+}
+
+bool DbManager::ensureCounters()
+{
+    QSqlQuery q(m_db);
+    bool added = false;
+    if (!hasColumn("activities", "enrolled_count")) {
+        if (!execOrFail(q, "ALTER TABLE activities ADD COLUMN enrolled_count INTEGER NOT NULL DEFAULT 0")) return false;
+        added = true;
+    }
+    if (!hasColumn("activities", "waiting_count")) {
+        if (!execOrFail(q, "ALTER TABLE activities ADD COLUMN waiting_count INTEGER NOT NULL DEFAULT 0")) return false;
+        added = true;
+    }
+    for (const QString &sql : counterTriggers()) {
+        if (!execOrFail(q, sql)) return false;
+    }
+    // 旧库首次加列时按明细回填一次
+    return added ? repairCounters() : true;
+}
+
+bool DbManager::isCorrupt(QString *detail)
+{
+    QSqlQuery q(m_db);
+    if (!q.exec("PRAGMA integrity_check")) {
+        if (detail) *detail = q.lastError().text();
+        // 取主错误码：SQLITE_CORRUPT(11) / SQLITE_NOTADB(26)
+        const int code = q.lastError().nativeErrorCode().toInt() & 0xff;
+        return code == 11 || code == 26;
+    }
+    QStringList problems;
+    while (q.next()) {
+        const QString line = q.value(0).toString();
+        if (line != "ok") problems << line;
+    }
+    if (detail) *detail = problems.join('\n');
+    return !problems.isEmpty();
+}
+
+bool DbManager::verifyCounters(int *mismatched)
+{
+    QSqlQuery q(m_db);
+    if (!execOrFail(q, QString("SELECT COUNT(*) FROM activities WHERE enrolled_count != %1 OR waiting_count != %2")
+                    .arg(kActiveCount, kWaitingCount))) {
+        return false;
+    }
+    const int bad = q.next() ? q.value(0).toInt() : 0;
+    if (mismatched) *mismatched = bad;
+    if (bad > 0) {
+        qWarning() << "activities counters out of sync:" << bad;
+    }
+    return bad == 0;
+}
+
+bool DbManager::repairCounters()
+{
+    QSqlQuery q(m_db);
+    return execOrFail(q, QString("UPDATE activities SET enrolled_count = %1, waiting_count = %2")
+                      .arg(kActiveCount, kWaitingCount));
 }
 
 bool DbManager::ensureSampleData()
@@ -202,8 +692,8 @@ bool DbManager::ensureSampleData()
 
 bool DbManager::validateUser(const QString &username, const QString &password, UserInfo &outUser)
 {
-    QSqlQuery q(m_db);
-    q.prepare("SELECT role FROM users WHERE username=? AND password=?");
+    const StatementLease stmt = prepared("SELECT role FROM users WHERE username=? AND password=?");
+    QSqlQuery &q = stmt.query();
     q.addBindValue(username);
     q.addBindValue(password);
     if (!q.exec()) {
@@ -218,11 +708,13 @@ bool DbManager::validateUser(const QString &username, const QString &password, U
     }
 
     // 如果用户表为空，尝试重新注入示例数据后再查一次（防止首次初始化失败）
-    QSqlQuery count(m_db);
-    if (count.exec("SELECT COUNT(*) FROM users") && count.next() && count.value(0).toInt() == 0) {
-        ensureSampleData();
+    const StatementLease countStmt = prepared("SELECT COUNT(*) FROM users");
+    QSqlQuery &count = countStmt.query();
+    if (count.exec() && count.next() && count.value(0).toInt() == 0) {
+        count.finish();
         q.finish();
-        q.prepare("SELECT role FROM users WHERE username=? AND password=?");
+        ensureSampleData();
+        // 同一条语句不嵌套取用，直接复用 q 重查
         q.addBindValue(username);
         q.addBindValue(password);
         if (q.exec() && q.next()) {
@@ -236,8 +728,8 @@ bool DbManager::validateUser(const QString &username, const QString &password, U
 
 bool DbManager::createUser(const QString &username, const QString &password, const QString &role, QString *error)
 {
-    QSqlQuery q(m_db);
-    q.prepare("INSERT INTO users(username,password,role) VALUES(?,?,?)");
+    const StatementLease stmt = prepared("INSERT INTO users(username,password,role) VALUES(?,?,?)");
+    QSqlQuery &q = stmt.query();
     q.addBindValue(username);
     q.addBindValue(password);
     q.addBindValue(role);
@@ -1,16 +1,34 @@
 #pragma once
 
 #include <QObject>
+#include <QDateTime>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QVariantList>
+#include "statementcache.h"
 
 struct UserInfo {
     QString username;
     QString role; // admin / initiator / student
 };
 
+// 每个 SQLite 连接打开后应用的 PRAGMA 组合
+// 设置项：database/profile = performance(默认) / safe / legacy，
+// 以及可选覆盖 database/journal_mode、synchronous、mmap_size、cache_size_kb、busy_timeout_ms、temp_store
+struct DbTuning {
+    QString name;
+    QString journalMode;    // WAL / DELETE
+    QString synchronous;    // OFF / NORMAL / FULL
+    qint64 mmapSize { 0 };  // 字节，0 表示关闭
+    int cacheSizeKb { 2000 };
+    int busyTimeoutMs { 5000 };
+    QString tempStore;      // DEFAULT / FILE / MEMORY
+
+    static DbTuning preset(const QString &name);
+    static DbTuning fromSettings();
+};
+
 class DbManager : public QObject
 {
     Q_OBJECT
@@ -18,11 +36,31 @@ public:
     explicit DbManager(QObject *parent = nullptr);
     ~DbManager();
     bool open(const QString &path);
+    // discard 为 true 时连接若无其他借用者则真正关闭（删除库文件前调用）
+    void close(bool discard = false);
     bool initSchema();
+    int schemaVersion();
+    // 对热点查询执行 EXPLAIN QUERY PLAN，全表扫描的行带 FULL-SCAN 标记
+    QStringList explainHotQueries();
+    static QString defaultPath();
+    // 本地时间转为库中 *_ts 列使用的整数秒
+    static qint64 toEpoch(const QDateTime &local);
+    static QString formatEpoch(qint64 ts, const QString &format);
+    // 库中是否建有 activities_fts（SQLite 不支持 FTS5 trigram 时不会创建）
+    static bool hasActivitySearch(const QSqlDatabase &db);
+    // 对连接应用调优参数，返回实际生效值的摘要（读回 PRAGMA）
+    static QString configureConnection(QSqlDatabase &db, const DbTuning &tuning);
 
     bool validateUser(const QString &username, const QString &password, UserInfo &outUser);
     bool createUser(const QString &username, const QString &password, const QString &role, QString *error = nullptr);
+    // 校验/重建 activities 上的冗余报名计数；verifyCounters 返回 false 表示存在不一致
+    bool verifyCounters(int *mismatched = nullptr);
+    bool repairCounters();
+    // PRAGMA integrity_check；只有确认损坏（或文件不是 SQLite 库）时返回 true，锁冲突等错误不算
+    bool isCorrupt(QString *detail = nullptr);
     QSqlDatabase database() const { return m_db; }
+    // 取当前连接上缓存的预编译语句（按 SQL 文本），离开作用域时 finish()，见 StatementCache
+    StatementLease prepared(const QString &sql);
     QString lastErrorText() const { return m_lastError; }
 
 signals:
@@ -30,8 +68,18 @@ signals:
 
 private:
     bool ensureSampleData();
+    bool migrate();
+    bool ensureCounters();
+    bool migrateHotIndexes();
+    bool migrateEpochColumns();
+    bool migrateActivitySearch();
+    bool ensureActivitySearch();
+    bool migrateAuditIndexes();
+    bool hasColumn(const QString &table, const QString &column);
+    bool execOrFail(QSqlQuery &q, const QString &sql);
     QSqlDatabase m_db;
+    QSqlQuery m_uncached;
     QString m_lastError;
-    QString m_connName;
+    bool m_leased { false };
 };
 
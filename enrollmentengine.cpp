@@ -0,0 +1,304 @@
+#include "enrollmentengine.h"
+#include "dbmanager.h"
+
+#include <QSqlError>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QVariant>
+
+namespace EnrollmentSql {
+const char kDuplicate[] =
+        "SELECT 1 FROM enrollments WHERE activity_id=? AND student=? AND status IN ('active','waiting') LIMIT 1";
+const char kActivity[] = R"(SELECT a.start_ts, a.end_ts, a.capacity, a.enrolled_count,
+                            (SELECT COALESCE(MAX(position),0)+1 FROM enrollments e WHERE e.activity_id=a.id AND e.status='waiting'),
+                            a.title
+                            FROM activities a WHERE a.id=? AND a.status='approved')";
+const char kStudentIntervals[] = R"(SELECT e.id, a.id, a.title, a.start_ts, a.end_ts
+                                    FROM enrollments e
+                                    JOIN activities a ON e.activity_id=a.id
+                                    WHERE e.student=? AND e.status='active' AND a.status!='cancelled')";
+const char kEnrollment[] = R"(SELECT e.activity_id, e.status, COALESCE(a.capacity, 0), COALESCE(a.enrolled_count, 0), e.student
+                              FROM enrollments e LEFT JOIN activities a ON e.activity_id=a.id
+                              WHERE e.id=?)";
+const char kNextWaiting[] =
+        "SELECT id, student FROM enrollments WHERE activity_id=? AND status='waiting' ORDER BY position LIMIT 1";
+}
+
+EnrollmentEngine::EnrollmentEngine(const QSqlDatabase &db)
+    : m_db(db)
+    , m_begin(db)
+    , m_commit(db)
+    , m_rollback(db)
+    , m_duplicate(db)
+    , m_activity(db)
+    , m_studentIntervals(db)
+    , m_insert(db)
+    , m_enrollment(db)
+    , m_cancel(db)
+    , m_nextWaiting(db)
+    , m_promote(db)
+    , m_dataVersion(db)
+{
+}
+
+bool EnrollmentEngine::prepareAll()
+{
+    if (m_prepared) return true;
+    m_prepared = m_begin.prepare("BEGIN IMMEDIATE")
+            && m_commit.prepare("COMMIT")
+            && m_rollback.prepare("ROLLBACK")
+            && m_duplicate.prepare(EnrollmentSql::kDuplicate)
+            // 时间、容量、当前报名数与下一个候补序号一次取回
+            && m_activity.prepare(EnrollmentSql::kActivity)
+            // 学生的有效报名区间，只在索引未加载时查询一次
+            && m_studentIntervals.prepare(EnrollmentSql::kStudentIntervals)
+            && m_insert.prepare("INSERT INTO enrollments(activity_id, student, created_at, created_ts, status, position) VALUES(?,?,?,?,?,?)")
+            && m_enrollment.prepare(EnrollmentSql::kEnrollment)
+            && m_cancel.prepare("UPDATE enrollments SET status='cancelled' WHERE id=?")
+            && m_nextWaiting.prepare(EnrollmentSql::kNextWaiting)
+            && m_promote.prepare("UPDATE enrollments SET status='active', position=0 WHERE id=?")
+            && m_dataVersion.prepare("PRAGMA data_version");
+    return m_prepared;
+}
+
+IntervalIndex *EnrollmentEngine::intervalsFor(const QString &student, QString *error)
+{
+    auto it = m_intervals.find(student);
+    if (it != m_intervals.end()) return &it.value();
+
+    m_studentIntervals.addBindValue(student);
+    if (!m_studentIntervals.exec()) {
+        if (error) *error = m_studentIntervals.lastError().text();
+        return nullptr;
+    }
+    QVector<IntervalIndex::Interval> items;
+    while (m_studentIntervals.next()) {
+        items << IntervalIndex::Interval{ m_studentIntervals.value(0).toInt(), m_studentIntervals.value(1).toInt(),
+                                          m_studentIntervals.value(2).toString(),
+                                          m_studentIntervals.value(3).toLongLong(), m_studentIntervals.value(4).toLongLong() };
+    }
+    m_studentIntervals.finish();
+    it = m_intervals.insert(student, IntervalIndex());
+    it->assign(std::move(items));
+    return &it.value();
+}
+
+bool EnrollmentEngine::warm(const QString &student, QString *error)
+{
+    if (!prepareAll()) {
+        if (error) *error = m_db.lastError().text();
+        return false;
+    }
+    return syncDataVersion(error) && intervalsFor(student, error) != nullptr;
+}
+
+void EnrollmentEngine::invalidateActivity(int activityId)
+{
+    // 活动时间或状态变化时丢弃受影响学生的索引，下次报名时重新加载
+    for (auto it = m_intervals.begin(); it != m_intervals.end();) {
+        if (it->containsActivity(activityId)) {
+            it = m_intervals.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool EnrollmentEngine::begin(QString *error)
+{
+    if (!prepareAll()) {
+        if (error) *error = m_db.lastError().text();
+        return false;
+    }
+    if (!m_begin.exec()) {
+        if (error) *error = m_begin.lastError().text();
+        return false;
+    }
+    // 已持有写锁，此时读到的版本之后不会再有其他连接的提交
+    if (!syncDataVersion(error)) {
+        rollback();
+        return false;
+    }
+    return true;
+}
+
+bool EnrollmentEngine::syncDataVersion(QString *error)
+{
+    if (!m_dataVersion.exec() || !m_dataVersion.next()) {
+        if (error) *error = m_dataVersion.lastError().text();
+        m_dataVersion.finish();
+        return false;
+    }
+    const qint64 version = m_dataVersion.value(0).toLongLong();
+    m_dataVersion.finish();
+    // 本连接自己的提交不改变 data_version；变化说明有别的连接写过，索引可能已过期
+    if (version != m_seenDataVersion) {
+        if (m_seenDataVersion >= 0) m_intervals.clear();
+        m_seenDataVersion = version;
+    }
+    return true;
+}
+
+void EnrollmentEngine::rollback()
+{
+    m_rollback.exec();
+}
+
+bool EnrollmentEngine::commit(QString *error)
+{
+    if (m_commit.exec()) return true;
+    if (error) *error = m_commit.lastError().text();
+    rollback();
+    return false;
+}
+
+EnrollResult EnrollmentEngine::enroll(int activityId, const QString &student, Mode mode)
+{
+    QElapsedTimer timer;
+    timer.start();
+    EnrollResult r;
+    r.activityId = activityId;
+
+    // 统一出口：结束所有游标、回滚未提交事务并记录耗时
+    auto finish = [&](EnrollResult::Outcome outcome, bool inTx) {
+        m_duplicate.finish();
+        m_activity.finish();
+        m_studentIntervals.finish();
+        if (inTx) rollback();
+        r.outcome = outcome;
+        r.elapsedUs = timer.nsecsElapsed() / 1000;
+        return r;
+    };
+
+    if (!begin(&r.error)) return finish(EnrollResult::Failed, false);
+
+    // 检查是否已报名或候补同一活动
+    m_duplicate.addBindValue(activityId);
+    m_duplicate.addBindValue(student);
+    if (!m_duplicate.exec()) {
+        r.error = m_duplicate.lastError().text();
+        return finish(EnrollResult::Failed, true);
+    }
+    if (m_duplicate.next()) return finish(EnrollResult::Duplicate, true);
+
+    m_activity.addBindValue(activityId);
+    if (!m_activity.exec() || !m_activity.next()) return finish(EnrollResult::NotAvailable, true);
+    const qint64 newStart = m_activity.value(0).toLongLong();
+    const qint64 newEnd = m_activity.value(1).toLongLong();
+    const int cap = m_activity.value(2).toInt();
+    const int enrolled = m_activity.value(3).toInt();
+    const int nextPosition = m_activity.value(4).toInt();
+    const QString title = m_activity.value(5).toString();
+    m_activity.finish();
+
+    const bool hasSlot = mode == Auto && enrolled < cap;
+    IntervalIndex *intervals = nullptr;
+    if (mode == Auto) {
+        // 与已报名活动冲突检测（仅比较 active 且未取消的活动），走内存区间索引
+        intervals = intervalsFor(student, &r.error);
+        if (!intervals) return finish(EnrollResult::Failed, true);
+        const QString fmt = QStringLiteral("MM-dd hh:mm");
+        for (const IntervalIndex::Interval &other : intervals->overlapping(newStart, newEnd)) {
+            r.conflicts << tr("与活动「%1」时间重叠：%2-%3 与 %4-%5")
+                              .arg(other.title,
+                                   DbManager::formatEpoch(other.start, fmt), DbManager::formatEpoch(other.end, fmt),
+                                   DbManager::formatEpoch(newStart, fmt), DbManager::formatEpoch(newEnd, fmt));
+        }
+        if (!r.conflicts.isEmpty()) return finish(EnrollResult::Conflict, true);
+    }
+
+    r.position = hasSlot ? 0 : nextPosition;
+    m_insert.addBindValue(activityId);
+    m_insert.addBindValue(student);
+    const QDateTime now = QDateTime::currentDateTime();
+    m_insert.addBindValue(now.toString(Qt::ISODate));
+    m_insert.addBindValue(DbManager::toEpoch(now));
+    m_insert.addBindValue(hasSlot ? "active" : "waiting");
+    m_insert.addBindValue(r.position);
+    if (!m_insert.exec()) {
+        r.error = m_insert.lastError().text();
+        return finish(EnrollResult::Failed, true);
+    }
+    r.enrollmentId = m_insert.lastInsertId().toInt();
+    if (!commit(&r.error)) return finish(EnrollResult::Failed, false);
+    r.enrolledCount = enrolled + (hasSlot ? 1 : 0);
+    if (hasSlot && intervals) {
+        intervals->insert(IntervalIndex::Interval{ r.enrollmentId, activityId, title, newStart, newEnd });
+    }
+    return finish(hasSlot ? EnrollResult::Enrolled : EnrollResult::Waitlisted, false);
+}
+
+CancelResult EnrollmentEngine::cancel(int enrollmentId, const QString &student)
+{
+    CancelResult r;
+    r.enrollmentId = enrollmentId;
+    if (!begin(&r.error)) return r;
+
+    m_enrollment.addBindValue(enrollmentId);
+    if (!m_enrollment.exec() || !m_enrollment.next()) {
+        r.error = m_enrollment.lastError().isValid() ? m_enrollment.lastError().text() : tr("报名记录不存在");
+        m_enrollment.finish();
+        rollback();
+        return r;
+    }
+    r.activityId = m_enrollment.value(0).toInt();
+    const QString status = m_enrollment.value(1).toString();
+    const bool wasActive = status == "active";
+    r.wasActive = wasActive;
+    const int cap = m_enrollment.value(2).toInt();
+    int enrolled = m_enrollment.value(3).toInt();
+    const QString owner = m_enrollment.value(4).toString();
+    m_enrollment.finish();
+
+    // 他人的记录与已取消的记录都不能再取消：后者会把已报名人数重复减一并多转正一名候补
+    if (owner != student) {
+        r.error = tr("只能取消本人的报名");
+        rollback();
+        return r;
+    }
+    if (!wasActive && status != "waiting") {
+        r.error = tr("该报名已取消");
+        rollback();
+        return r;
+    }
+
+    m_cancel.addBindValue(enrollmentId);
+    if (!m_cancel.exec()) {
+        r.error = m_cancel.lastError().text();
+        rollback();
+        return r;
+    }
+    if (wasActive) --enrolled;
+
+    // 仅在确有空余名额时将候补第1位转正，避免取消候补记录时超额
+    QString promotedStudent;
+    if (enrolled < cap) {
+        m_nextWaiting.addBindValue(r.activityId);
+        if (m_nextWaiting.exec() && m_nextWaiting.next()) {
+            const int wid = m_nextWaiting.value(0).toInt();
+            promotedStudent = m_nextWaiting.value(1).toString();
+            m_nextWaiting.finish();
+            m_promote.addBindValue(wid);
+            if (!m_promote.exec()) {
+                r.error = m_promote.lastError().text();
+                rollback();
+                return r;
+            }
+            r.promotedId = wid;
+        }
+        m_nextWaiting.finish();
+    }
+    r.ok = commit(&r.error);
+    if (!r.ok) {
+        r.promotedId = -1;
+        return r;
+    }
+    r.enrolledCount = enrolled + (r.promotedId >= 0 ? 1 : 0);
+    // 同步内存区间索引：被取消的记录移出，转正学生的索引重新加载
+    if (wasActive) {
+        auto it = m_intervals.find(student);
+        if (it != m_intervals.end()) it->removeEnrollment(enrollmentId);
+    }
+    if (r.promotedId >= 0) m_intervals.remove(promotedStudent);
+    return r;
+}
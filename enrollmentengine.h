@@ -0,0 +1,93 @@
+#pragma once
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStringList>
+#include "utils/intervalindex.h"
+
+struct EnrollResult {
+    enum Outcome { Enrolled, Waitlisted, Duplicate, NotAvailable, Conflict, Failed };
+    Outcome outcome { Failed };
+    int activityId { -1 };
+    int enrollmentId { -1 };
+    int position { 0 };
+    int enrolledCount { -1 }; // 提交后活动的已报名人数
+    QStringList conflicts;
+    QString error;
+    qint64 elapsedUs { 0 }; // 整个事务耗时（微秒）
+};
+Q_DECLARE_METATYPE(EnrollResult)
+
+struct CancelResult {
+    bool ok { false };
+    int enrollmentId { -1 };
+    int activityId { -1 };
+    int promotedId { -1 }; // 被转正的候补记录，-1 表示无
+    bool wasActive { false }; // 被取消的是已报名（而非候补）记录
+    int enrolledCount { -1 }; // 提交后活动的已报名人数
+    QString error;
+};
+Q_DECLARE_METATYPE(CancelResult)
+
+// 报名引擎事务内的查询语句；DbManager::explainHotQueries 直接检查这些文本的查询计划，两处不会走样
+namespace EnrollmentSql {
+extern const char kDuplicate[];
+extern const char kActivity[];         // 时间、容量、当前报名数、下一个候补序号与标题
+extern const char kStudentIntervals[]; // 学生的有效报名区间
+extern const char kEnrollment[];       // 取消时读取记录与活动容量
+extern const char kNextWaiting[];      // 候补第 1 位
+}
+
+// 报名决策引擎：查重、容量、候补序号、时间冲突与写入在同一个 BEGIN IMMEDIATE 事务中完成，
+// 并发报名不会超额。语句在首次使用时 prepare，之后在同一连接上反复复用。
+// 冲突检测使用按学生缓存的内存区间索引（首次用到或 warm 时从库加载），
+// 报名/取消成功后同步更新；活动时间或状态变化需调用 invalidateActivity。
+// 其他连接（其他线程、其他进程）提交过写入时 PRAGMA data_version 会变化，此时整体丢弃索引。
+// 非线程安全：每个连接（线程）各持有一个实例。
+class EnrollmentEngine
+{
+    Q_DECLARE_TR_FUNCTIONS(EnrollmentEngine)
+public:
+    enum Mode {
+        Auto,        // 有名额直接报名，否则进入候补
+        WaitlistOnly // 直接加入候补队列，不做冲突检查
+    };
+
+    explicit EnrollmentEngine(const QSqlDatabase &db);
+
+    EnrollResult enroll(int activityId, const QString &student, Mode mode = Auto);
+    // 只能取消 student 本人且仍有效（已报名/候补）的记录，校验与更新在同一事务内
+    CancelResult cancel(int enrollmentId, const QString &student);
+
+    // 预先加载学生的区间索引（如登录时），避免首次报名时再查询
+    bool warm(const QString &student, QString *error = nullptr);
+    void invalidateActivity(int activityId);
+
+private:
+    bool prepareAll();
+    IntervalIndex *intervalsFor(const QString &student, QString *error);
+    bool begin(QString *error);
+    // 读取 data_version，与上次不同则清空区间索引
+    bool syncDataVersion(QString *error);
+    void rollback();
+    bool commit(QString *error);
+
+    QSqlDatabase m_db;
+    bool m_prepared { false };
+    QSqlQuery m_begin;
+    QSqlQuery m_commit;
+    QSqlQuery m_rollback;
+    QSqlQuery m_duplicate;
+    QSqlQuery m_activity;
+    QSqlQuery m_studentIntervals;
+    QSqlQuery m_insert;
+    QSqlQuery m_enrollment;
+    QSqlQuery m_cancel;
+    QSqlQuery m_nextWaiting;
+    QSqlQuery m_promote;
+    QSqlQuery m_dataVersion;
+    qint64 m_seenDataVersion { -1 };
+    QHash<QString, IntervalIndex> m_intervals;
+};
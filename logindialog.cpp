@@ -2,9 +2,6 @@
 #include "ui_logindialog.h"
 
 #include <QMessageBox>
-#include <QStandardPaths>
-#include <QDir>
-#include <QFileInfo>
 
 LoginDialog::LoginDialog(QWidget *parent) :
     QDialog(parent),
@@ -15,17 +12,9 @@ LoginDialog::LoginDialog(QWidget *parent) :
     ui->passwordEdit->setEchoMode(QLineEdit::Password);
 
     // Init DB
-    const QString dbPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
-            + QDir::separator() + "activity.db";
-    QDir().mkpath(QFileInfo(dbPath).absolutePath());
-
-    auto openOrReset = [this](const QString &p)->bool {
-        if (m_db.open(p) && m_db.initSchema()) return true;
-        QFile::remove(p);
-        return m_db.open(p) && m_db.initSchema();
-    };
-    if (!openOrReset(dbPath)) {
-        QMessageBox::critical(this, tr("错误"), tr("数据库无法打开/初始化: %1").arg(m_db.lastErrorText()));
+    QString err;
+    if (!m_core.open(DbManager::defaultPath(), &err)) {
+        QMessageBox::critical(this, tr("错误"), tr("数据库无法打开/初始化: %1").arg(err));
     }
 
     connect(ui->loginButton, &QPushButton::clicked, this, &LoginDialog::onLogin);
@@ -37,54 +26,41 @@ LoginDialog::~LoginDialog()
     delete ui;
 }
 
-void LoginDialog::onLogin()
+QString LoginDialog::selectedRole() const
 {
-    const QString user = ui->usernameEdit->text().trimmed();
-    const QString pwd = ui->passwordEdit->text();
-    QString role;
     switch (ui->roleCombo->currentIndex()) {
-    case 0: role = "admin"; break;
-    case 1: role = "initiator"; break;
-    case 2: role = "student"; break;
-    default: role.clear(); break;
+    case 0: return "admin";
+    case 1: return "initiator";
+    case 2: return "student";
+    default: return QString();
     }
-    if (user.isEmpty() || pwd.isEmpty() || role.isEmpty()) {
-        QMessageBox::warning(this, tr("提示"), tr("请输入用户名、密码并选择角色"));
+}
+
+void LoginDialog::onLogin()
+{
+    const LoginResult r = m_core.login(ui->usernameEdit->text().trimmed(), ui->passwordEdit->text(), selectedRole());
+    if (r.outcome == LoginResult::MissingInput) {
+        QMessageBox::warning(this, tr("提示"), r.error);
         return;
     }
     ui->hintLabel->clear();
-    UserInfo info;
-    if (!m_db.validateUser(user, pwd, info)) {
-        ui->hintLabel->setText(tr("用户名或密码错误"));
+    if (r.outcome != LoginResult::LoggedIn) {
+        ui->hintLabel->setText(r.error);
         return;
     }
-    if (info.role != role) {
-        ui->hintLabel->setText(tr("角色不匹配，当前账号角色：%1").arg(info.role));
-        return;
-    }
-    m_user = info;
+    m_user = r.user;
     accept();
 }
 
 void LoginDialog::onRegister()
 {
-    const QString user = ui->usernameEdit->text().trimmed();
-    const QString pwd = ui->passwordEdit->text();
-    QString role;
-    switch (ui->roleCombo->currentIndex()) {
-    case 0: role = "admin"; break;
-    case 1: role = "initiator"; break;
-    case 2: role = "student"; break;
-    default: role.clear(); break;
-    }
-    if (user.isEmpty() || pwd.isEmpty() || role.isEmpty()) {
-        QMessageBox::warning(this, tr("提示"), tr("请输入用户名、密码并选择角色"));
-        return;
-    }
-    QString err;
-    if (m_db.createUser(user, pwd, role, &err)) {
+    const ActionResult r = m_core.registerUser(ui->usernameEdit->text().trimmed(), ui->passwordEdit->text(),
+                                               selectedRole());
+    if (r.rejected) {
+        QMessageBox::warning(this, tr("提示"), r.error);
+    } else if (r.ok) {
         ui->hintLabel->setText(tr("账号创建成功，可直接登录"));
     } else {
-        ui->hintLabel->setText(tr("创建失败: %1").arg(err));
+        ui->hintLabel->setText(tr("创建失败: %1").arg(r.error));
     }
 }
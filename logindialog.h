@@ -1,7 +1,7 @@
 #pragma once
 
 #include <QDialog>
-#include "dbmanager.h"
+#include "campuscore.h"
 
 namespace Ui {
 class LoginDialog;
@@ -22,8 +22,10 @@ private slots:
     void onRegister();
 
 private:
+    QString selectedRole() const;
+
     Ui::LoginDialog *ui;
-    DbManager m_db;
+    CampusCore m_core;
     UserInfo m_user;
 };
 
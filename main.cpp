@@ -1,8 +1,13 @@
 #include "mainwindow.h"
 #include "logindialog.h"
+#include "auditsink.h"
+#include "connectionpool.h"
 
 #include <QApplication>
 #include <QStyleFactory>
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
 
 int main(int argc, char *argv[])
 {
@@ -12,6 +17,23 @@ int main(int argc, char *argv[])
     QCoreApplication::setApplicationName("ActivityManager");
     QCoreApplication::setApplicationVersion("1.0");
 
+    // 诊断：输出热点查询的执行计划后退出，用于确认索引是否生效
+    if (a.arguments().contains("--explain-queries")) {
+        const QString dbPath = DbManager::defaultPath();
+        QDir().mkpath(QFileInfo(dbPath).absolutePath());
+        DbManager db;
+        if (!db.open(dbPath) || !db.initSchema()) {
+            QTextStream(stderr) << db.lastErrorText() << '\n';
+            return 1;
+        }
+        QTextStream out(stdout);
+        out << "schema version " << db.schemaVersion() << '\n';
+        for (const QString &line : db.explainHotQueries()) {
+            out << line << '\n';
+        }
+        return 0;
+    }
+
     auto *login = new LoginDialog();
     login->show();
 
@@ -42,6 +64,16 @@ int main(int argc, char *argv[])
         }
     });
 
-    return a.exec();
+    const int rc = a.exec();
+    // 写完仍在队列中的审计日志再退出
+    AuditSink::instance().shutdown();
+    const AuditStats audit = AuditSink::instance().stats();
+    qInfo("Audit log: queued=%llu written=%llu batches=%llu dropped=%llu archived=%llu",
+          audit.queued, audit.written, audit.batches, audit.dropped, audit.archived);
+    const PoolStats stats = ConnectionPool::instance().stats();
+    qInfo("Connection pool: leases=%llu waits=%llu opened=%llu open=%d peak=%d max=%d stmt_hits=%llu stmt_misses=%llu stmt_evicted=%llu",
+          stats.leases, stats.waits, stats.opened, stats.openCount, stats.peakOpen, stats.maxConnections,
+          stats.statementHits, stats.statementMisses, stats.statementEvictions);
+    return rc;
 }
 
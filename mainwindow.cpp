@@ -1,18 +1,17 @@
 #include "mainwindow.h"
+#include "auditsink.h"
 #include "ui_mainwindow.h"
 
 #include <QStandardPaths>
 #include <QDir>
 #include <QMessageBox>
-#include <QSqlQuery>
-#include <QSqlError>
 #include <QDateTime>
 #include <QFileDialog>
 #include <QTableView>
 #include <QDebug>
 #include <QTimer>
-#include <QFile>
 #include <QHeaderView>
+#include <algorithm>
 
 MainWindow::MainWindow(const UserInfo &user, QWidget *parent)
     : QMainWindow(parent)
@@ -21,28 +20,16 @@ MainWindow::MainWindow(const UserInfo &user, QWidget *parent)
     , m_activityModel(nullptr)
     , m_enrollmentModel(nullptr)
     , m_waitlistModel(nullptr)
-    , m_upcomingModel(new QSqlQueryModel(this))
-    , m_reportPreviewModel(new QSqlQueryModel(this))
+    , m_upcomingModel(new RowTableModel(this))
+    , m_reportPreviewModel(new RowTableModel(this))
     , m_reportWorker(new ReportWorker)
+    , m_dataService(new DataService)
 {
     ui->setupUi(this);
     setWindowTitle(tr("校园活动管理 - %1 (%2)").arg(user.username, user.role));
 
-    const QString dbPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
-            + QDir::separator() + "activity.db";
-    QDir().mkpath(QFileInfo(dbPath).absolutePath());
-
-    auto openOrReset = [this](const QString &p)->bool {
-        if (m_db.open(p) && m_db.initSchema()) return true;
-        QFile::remove(p);
-        return m_db.open(p) && m_db.initSchema();
-    };
-    if (!openOrReset(dbPath)) {
-        QMessageBox::critical(this, tr("错误"), tr("数据库打开或初始化失败: %1").arg(m_db.lastErrorText()));
-        QTimer::singleShot(0, this, &MainWindow::close);
-        return;
-    }
-
+    // 库已由登录对话框打开并完成初始化/迁移；本窗口的全部数据库访问都经数据服务线程，
+    // 审计日志经 AuditSink 异步写入，UI 线程不执行 SQL
     setupUiState();
     bindModels();
 
@@ -66,14 +53,29 @@ MainWindow::MainWindow(const UserInfo &user, QWidget *parent)
 
     connect(ui->exportCsvButton, &QPushButton::clicked, this, &MainWindow::onExportCsv);
     connect(ui->runReportButton, &QPushButton::clicked, this, &MainWindow::onRunReport);
+    connect(ui->cancelReportButton, &QPushButton::clicked, this, &MainWindow::onCancelReport);
     connect(ui->logoutButton, &QPushButton::clicked, this, &MainWindow::onLogout);
+    connect(ui->auditQueryButton, &QPushButton::clicked, this, &MainWindow::reloadAuditLog);
 
-    connect(ui->categoryFilter, &QComboBox::currentTextChanged, this, &MainWindow::reloadActivities);
-    connect(ui->statusFilter, &QComboBox::currentTextChanged, this, &MainWindow::reloadActivities);
-    connect(ui->keywordEdit, &QLineEdit::textChanged, this, &MainWindow::reloadActivities);
+    // 输入过程中合并连续变化，停顿后才查询一次
+    m_filterDebounce.setSingleShot(true);
+    m_filterDebounce.setInterval(250);
+    connect(&m_filterDebounce, &QTimer::timeout, this, &MainWindow::reloadActivities);
+    connect(ui->categoryFilter, &QComboBox::currentTextChanged, this, [this]() { m_filterDebounce.start(); });
+    connect(ui->statusFilter, &QComboBox::currentTextChanged, this, [this]() { m_filterDebounce.start(); });
+    connect(ui->keywordEdit, &QLineEdit::textChanged, this, [this]() { m_filterDebounce.start(); });
 
     connect(ui->activityTable->selectionModel(), &QItemSelectionModel::selectionChanged,
             this, &MainWindow::onActivitySelected);
+    // 选中行的页随后才加载到时补填表单
+    connect(m_activityModel, &QAbstractItemModel::dataChanged, this,
+            [this](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+        const int row = ui->activityTable->currentIndex().row();
+        if (row >= topLeft.row() && row <= bottomRight.row()
+                && ui->titleEdit->property("activityId").isNull()) {
+            fillFormFromSelection();
+        }
+    });
 
     connect(&m_network, &NetworkService::announcementsReady, this, [this](const QStringList &items){
         ui->announcementList->clear();
@@ -89,14 +91,48 @@ MainWindow::MainWindow(const UserInfo &user, QWidget *parent)
         }
     });
 
-    m_reportWorker->setDatabase(m_db.database());
     m_reportWorker->moveToThread(&m_workerThread);
     connect(&m_workerThread, &QThread::finished, m_reportWorker, &QObject::deleteLater);
     connect(this, &MainWindow::destroyed, &m_workerThread, &QThread::quit);
+    connect(m_reportWorker, &ReportWorker::jobStarted, this, &MainWindow::onReportJobStarted);
+    connect(m_reportWorker, &ReportWorker::jobProgress, this, &MainWindow::onReportJobProgress);
+    connect(m_reportWorker, &ReportWorker::jobFinished, this, &MainWindow::onReportJobFinished);
     connect(m_reportWorker, &ReportWorker::finished, this, &MainWindow::onReportFinished);
-    connect(m_reportWorker, &ReportWorker::conflictChecked, this, &MainWindow::onConflictResult);
+    connect(m_reportWorker, &ReportWorker::conflictsFound, this, &MainWindow::onConflictsFound);
+    connect(m_reportWorker, &ReportWorker::conflictCheckFinished, this, &MainWindow::onConflictCheckFinished);
     m_workerThread.start();
 
+    // 交互类 SQL 全部在数据服务线程执行，UI 只接收结果
+    m_dataService->moveToThread(&m_dataThread);
+    connect(&m_dataThread, &QThread::finished, m_dataService, &QObject::deleteLater);
+    connect(m_dataService, &DataService::activityQueryReady, m_activityModel, &PagedTableModel::setQuery);
+    connect(m_dataService, &DataService::pageLoaded, m_activityModel, &PagedTableModel::onPageLoaded);
+    connect(m_activityModel, &PagedTableModel::pageRequested, m_dataService, &DataService::fetchPage);
+    if (m_auditModel) {
+        connect(m_dataService, &DataService::auditQueryReady, m_auditModel, &PagedTableModel::setQuery);
+        connect(m_dataService, &DataService::pageLoaded, m_auditModel, &PagedTableModel::onPageLoaded);
+        connect(m_auditModel, &PagedTableModel::pageRequested, m_dataService, &DataService::fetchPage);
+    }
+    connect(m_dataService, &DataService::upcomingLoaded, m_upcomingModel, &RowTableModel::setRows);
+    connect(m_dataService, &DataService::activitiesPatched, m_activityModel, &PagedTableModel::applyPatch);
+    connect(m_dataService, &DataService::statsLoaded, this, &MainWindow::onStatsLoaded);
+    if (m_enrollmentModel) {
+        connect(m_dataService, &DataService::availableActivitiesLoaded, m_enrollmentModel, &RowTableModel::setRows);
+        connect(m_dataService, &DataService::myEnrollmentsLoaded, m_waitlistModel, &RowTableModel::setRows);
+        connect(m_dataService, &DataService::availableActivitiesPatched, m_enrollmentModel, &RowTableModel::applyPatch);
+        connect(m_dataService, &DataService::myEnrollmentsPatched, m_waitlistModel, &RowTableModel::applyPatch);
+    }
+    connect(m_dataService, &DataService::enrollFinished, this, &MainWindow::onEnrollFinished);
+    connect(m_dataService, &DataService::waitlistFinished, this, &MainWindow::onWaitlistFinished);
+    connect(m_dataService, &DataService::cancelFinished, this, &MainWindow::onCancelFinished);
+    connect(m_dataService, &DataService::activityActionFinished, this, &MainWindow::onActivityActionFinished);
+    connect(m_dataService, &DataService::studentConflictsLoaded, this, &MainWindow::onStudentConflictsLoaded);
+    connect(m_dataService, &DataService::exportFinished, this, &MainWindow::onExportFinished);
+    m_dataThread.start();
+    if (m_user.role == "student") {
+        m_dataService->warmStudent(m_user.username);
+    }
+
     // 强制离线模式（避免 OpenSSL 缺失导致崩溃），使用本地占位数据
     m_network.setNetworkEnabled(false);
     ui->announcementList->clear();
@@ -114,15 +150,24 @@ MainWindow::MainWindow(const UserInfo &user, QWidget *parent)
 
     // 如需联网获取，去掉上方 setNetworkEnabled(false) 并解除下行注释
     // loadAnnouncements();
+    m_filterDebounce.stop();
     reloadActivities();
+    m_dataService->loadUpcoming();
     reloadEnrollments();
     reloadStats();
 }
 
 MainWindow::~MainWindow()
 {
+    // 报表进行中时先取消并等线程池作业停下，否则线程仍在运行就被销毁、作业回写已删除的 worker；
+    // generateReport 随后返回，工作线程才会处理 quit
+    m_reportWorker->cancel();
+    m_reportWorker->waitForJobs();
     m_workerThread.quit();
-    m_workerThread.wait(500);
+    m_workerThread.wait();
+    // 等待已投递的写操作完成，避免退出时丢失
+    m_dataThread.quit();
+    m_dataThread.wait();
     delete ui;
 }
 
@@ -145,6 +190,15 @@ void MainWindow::setupUiState()
     } else {
         if (idxEnroll != -1) ui->tabWidget->removeTab(idxEnroll);
     }
+    // 审计日志仅管理员可见
+    const int idxAudit = ui->tabWidget->indexOf(ui->tabAudit);
+    if (!isAdmin && idxAudit != -1) ui->tabWidget->removeTab(idxAudit);
+    ui->auditActionFilter->addItems(QStringList() << "" << "activity_submit" << "activity_approve" << "activity_reject"
+                                    << "activity_delete" << "enroll" << "waitlist" << "enroll_cancel"
+                                    << "export_my_enroll" << "export_enrollments" << "report_generate" << "report_cancel");
+    // 默认查看最近一周
+    ui->auditFromEdit->setDateTime(QDateTime::currentDateTime().addDays(-7));
+    ui->auditToEdit->setDateTime(QDateTime::currentDateTime().addDays(1));
 
     // 按角色控制按钮/表单
     ui->newActivityButton->setVisible(isInitiator);
@@ -183,21 +237,36 @@ void MainWindow::setupUiState()
 
 void MainWindow::bindModels()
 {
-    m_activityModel = new ActivityModel(this, m_db.database());
+    m_activityModel = new ActivityModel(this);
     ui->activityTable->setModel(m_activityModel);
     ui->activityTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     ui->activityTable->setSelectionMode(QAbstractItemView::SingleSelection);
     ui->activityTable->setColumnHidden(0, true);
+    // 无排序指示时沿用查询自带顺序（开始时间/相关度），点击表头改为按索引列排序
+    ui->activityTable->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+    ui->activityTable->setSortingEnabled(true);
+
+    if (m_user.role == "admin") {
+        m_auditModel = new AuditLogModel(this);
+        ui->auditTable->setModel(m_auditModel);
+        ui->auditTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+        ui->auditTable->setColumnHidden(0, true);
+        ui->auditTable->horizontalHeader()->setStretchLastSection(true);
+        auto updateCount = [this]() { ui->auditCountLabel->setText(tr("共 %1 条").arg(m_auditModel->rowCount())); };
+        connect(m_auditModel, &QAbstractItemModel::modelReset, this, updateCount);
+        connect(m_auditModel, &QAbstractItemModel::rowsInserted, this, updateCount);
+        connect(m_auditModel, &QAbstractItemModel::rowsRemoved, this, updateCount);
+    }
 
     // 报名模型仅学生需要绑定
     if (m_user.role == "student") {
-        m_enrollmentModel = new EnrollmentModel(this, m_db.database());
+        m_enrollmentModel = new EnrollmentModel(this);
         ui->enrollmentActivityTable->setModel(m_enrollmentModel);
         ui->enrollmentActivityTable->setSelectionBehavior(QAbstractItemView::SelectRows);
         ui->enrollmentActivityTable->setSelectionMode(QAbstractItemView::SingleSelection);
         ui->enrollmentActivityTable->setColumnHidden(0, true);
 
-        m_waitlistModel = new EnrollmentModel(this, m_db.database());
+        m_waitlistModel = new EnrollmentModel(this);
         ui->waitlistTable->setModel(m_waitlistModel);
         ui->waitlistTable->setSelectionBehavior(QAbstractItemView::SelectRows);
         ui->waitlistTable->setSelectionMode(QAbstractItemView::SingleSelection);
@@ -213,16 +282,28 @@ void MainWindow::loadAnnouncements()
 
 void MainWindow::reloadActivities()
 {
-    const QString cat = ui->categoryFilter->currentData().toString();
-    const QString status = ui->statusFilter->currentText();
-    const QString keyword = ui->keywordEdit->text();
-    m_activityModel->applyFilter(m_user.role, m_user.username, cat, status, keyword);
+    ActivityFilter filter;
+    filter.role = m_user.role;
+    filter.username = m_user.username;
+    filter.category = ui->categoryFilter->currentData().toString();
+    filter.status = ui->statusFilter->currentText();
+    filter.keyword = ui->keywordEdit->text();
+    // 近期活动与筛选条件无关，由启动加载与 DataService 的变更推送维护
+    if (m_activityFilterLoaded && filter == m_lastActivityFilter) return;
+    m_activityFilterLoaded = true;
+    m_lastActivityFilter = filter;
+    m_dataService->loadActivities(filter);
+}
 
-    // upcoming table
-    QSqlQuery q(m_db.database());
-    q.exec(R"(SELECT title AS 标题, start_time AS 开始, end_time AS 结束, location AS 地点, status AS 状态
-              FROM activities WHERE status!='cancelled' ORDER BY start_time LIMIT 20)");
-    m_upcomingModel->setQuery(q);
+void MainWindow::reloadAuditLog()
+{
+    if (!m_auditModel) return;
+    AuditFilter filter;
+    filter.actor = ui->auditActorEdit->text().trimmed();
+    filter.action = ui->auditActionFilter->currentText();
+    filter.from = ui->auditFromEdit->dateTime();
+    filter.to = ui->auditToEdit->dateTime();
+    m_dataService->loadAuditLog(filter);
 }
 
 void MainWindow::reloadEnrollments()
@@ -230,29 +311,25 @@ void MainWindow::reloadEnrollments()
     if (m_user.role != "student") {
         return;
     }
-    m_enrollmentModel->loadAvailableActivities();
-    m_waitlistModel->loadMyEnrollments(m_user.username, false);
+    m_dataService->loadAvailableActivities();
+    m_dataService->loadMyEnrollments(m_user.username);
 }
 
 void MainWindow::reloadStats()
 {
-    QSqlQuery q(m_db.database());
-    q.exec("SELECT COUNT(*) FROM activities");
-    if (q.next()) ui->labelTotalAct->setText(tr("活动总数: %1").arg(q.value(0).toInt()));
-    q.exec("SELECT COUNT(*) FROM enrollments WHERE status='active'");
-    if (q.next()) ui->labelTotalEnroll->setText(tr("报名总数: %1").arg(q.value(0).toInt()));
-    q.exec("SELECT COUNT(*) FROM activities WHERE status='approved'");
-    if (q.next()) ui->labelApproved->setText(tr("已审核: %1").arg(q.value(0).toInt()));
-    q.exec("SELECT COUNT(*) FROM activities WHERE status='pending'");
-    if (q.next()) ui->labelPending->setText(tr("待审核: %1").arg(q.value(0).toInt()));
-
-    q.exec(R"(SELECT a.title AS 活动, COUNT(*) AS 报名人数
-              FROM enrollments e JOIN activities a ON e.activity_id=a.id
-              WHERE e.status='active'
-              GROUP BY a.id
-              ORDER BY 报名人数 DESC
-              LIMIT 10)");
-    m_reportPreviewModel->setQuery(q);
+    m_dataService->loadStats();
+}
+
+void MainWindow::onStatsLoaded(const DashboardStats &stats)
+{
+    // 快照未变化时不重置预览表，避免选中与滚动位置丢失
+    if (stats.version == m_statsVersion) return;
+    m_statsVersion = stats.version;
+    ui->labelTotalAct->setText(tr("活动总数: %1").arg(stats.totalActivities));
+    ui->labelTotalEnroll->setText(tr("报名总数: %1").arg(stats.activeEnrollments));
+    ui->labelApproved->setText(tr("已审核: %1").arg(stats.approved));
+    ui->labelPending->setText(tr("待审核: %1").arg(stats.pending));
+    m_reportPreviewModel->setRows(stats.topActivities);
 }
 
 void MainWindow::onActivitySelected(const QItemSelection &selected)
@@ -264,14 +341,16 @@ void MainWindow::onActivitySelected(const QItemSelection &selected)
 void MainWindow::fillFormFromSelection()
 {
     const int row = ui->activityTable->currentIndex().row();
-    if (row < 0) {
+    // 所在页尚未加载的行只有占位文本，等 dataChanged 到达后再填
+    const int id = row < 0 ? -1 : m_activityModel->idForRow(row);
+    if (id < 0) {
         ui->titleEdit->clear();
+        ui->titleEdit->setProperty("activityId", QVariant());
         ui->locationEdit->clear();
         ui->capacitySpin->setValue(50);
         ui->statusEdit->clear();
         return;
     }
-    auto idx = m_activityModel->index(row, 0);
     ui->titleEdit->setText(m_activityModel->data(m_activityModel->index(row, 1)).toString());
     ui->categoryEdit->setCurrentText(m_activityModel->data(m_activityModel->index(row, 2)).toString());
     ui->locationEdit->setText(m_activityModel->data(m_activityModel->index(row, 3)).toString());
@@ -279,319 +358,157 @@ void MainWindow::fillFormFromSelection()
     ui->endEdit->setDateTime(QDateTime::fromString(m_activityModel->data(m_activityModel->index(row, 5)).toString(), Qt::ISODate));
     ui->capacitySpin->setValue(m_activityModel->data(m_activityModel->index(row, 6)).toInt());
     ui->statusEdit->setText(m_activityModel->data(m_activityModel->index(row, 8)).toString());
-    ui->titleEdit->setProperty("activityId", idx.data());
+    ui->titleEdit->setProperty("activityId", id);
 }
 
-bool MainWindow::saveActivity(bool isNew)
+void MainWindow::saveActivity(bool isNew)
 {
-    if (m_user.role != "initiator") {
-        QMessageBox::warning(this, tr("权限"), tr("仅发起人可发布/编辑活动"));
-        return false;
-    }
-    const QString title = ui->titleEdit->text().trimmed();
-    if (title.isEmpty()) {
-        QMessageBox::warning(this, tr("校验"), tr("标题不能为空"));
-        return false;
-    }
-    if (ui->capacitySpin->value() <= 0) {
-        QMessageBox::warning(this, tr("校验"), tr("容量必须大于 0"));
-        return false;
-    }
-    if (ui->endEdit->dateTime() <= ui->startEdit->dateTime()) {
-        QMessageBox::warning(this, tr("校验"), tr("结束时间必须晚于开始时间"));
-        return false;
-    }
-    if (ui->startEdit->dateTime() < QDateTime::currentDateTime().addSecs(-60)) {
-        QMessageBox::warning(this, tr("校验"), tr("开始时间不能早于当前时间"));
-        return false;
-    }
-    QSqlQuery q(m_db.database());
-    if (isNew) {
-        q.prepare(R"(INSERT INTO activities(title, category, location, start_time, end_time, capacity, status, creator)
-                     VALUES(?,?,?,?,?,?, 'pending', ?))");
-        q.addBindValue(title);
-        q.addBindValue(ui->categoryEdit->currentText());
-        q.addBindValue(ui->locationEdit->text());
-        q.addBindValue(ui->startEdit->dateTime().toString(Qt::ISODate));
-        q.addBindValue(ui->endEdit->dateTime().toString(Qt::ISODate));
-        q.addBindValue(ui->capacitySpin->value());
-        q.addBindValue(m_user.username);
-    } else {
-        const int id = ui->titleEdit->property("activityId").toInt();
-        q.prepare(R"(UPDATE activities SET title=?, category=?, location=?, start_time=?, end_time=?, capacity=? WHERE id=?)");
-        q.addBindValue(title);
-        q.addBindValue(ui->categoryEdit->currentText());
-        q.addBindValue(ui->locationEdit->text());
-        q.addBindValue(ui->startEdit->dateTime().toString(Qt::ISODate));
-        q.addBindValue(ui->endEdit->dateTime().toString(Qt::ISODate));
-        q.addBindValue(ui->capacitySpin->value());
-        q.addBindValue(id);
-    }
-    if (!q.exec()) {
-        QMessageBox::critical(this, tr("数据库错误"), q.lastError().text());
-        return false;
-    }
-    return true;
+    // 权限与输入校验由 CampusCore 完成，未通过时经 activityActionFinished 返回原因
+    ActivityDraft draft;
+    draft.id = isNew ? -1 : ui->titleEdit->property("activityId").toInt();
+    draft.title = ui->titleEdit->text();
+    draft.category = ui->categoryEdit->currentText();
+    draft.location = ui->locationEdit->text();
+    draft.startTime = ui->startEdit->dateTime().toString(Qt::ISODate);
+    draft.endTime = ui->endEdit->dateTime().toString(Qt::ISODate);
+    draft.capacity = ui->capacitySpin->value();
+    m_dataService->saveActivity(draft, m_user);
 }
 
 void MainWindow::onSubmitActivity()
 {
-    if (m_user.role != "initiator") {
-        QMessageBox::warning(this, tr("权限"), tr("仅发起人可发布活动"));
-        return;
-    }
     const bool isNew = ui->titleEdit->property("activityId").isNull();
-    if (saveActivity(isNew)) {
-        reloadActivities();
-        reloadEnrollments();
-        reloadStats();
-        QMessageBox::information(this, tr("成功"), tr("已提交活动"));
-        ui->titleEdit->setProperty("activityId", QVariant());
-        logAudit("activity_submit", ui->titleEdit->text(), isNew ? "new" : "update");
-    }
+    ui->submitActivityButton->setEnabled(false);
+    saveActivity(isNew);
 }
 
 void MainWindow::onApprove()
 {
-    if (m_user.role != "admin") {
-        QMessageBox::warning(this, tr("权限"), tr("仅管理员可审批"));
-        return;
-    }
     const int id = selectedActivityId(ui->activityTable);
     if (id < 0) return;
-    QSqlQuery q(m_db.database());
-    q.prepare("UPDATE activities SET status='approved', approver=? WHERE id=?");
-    q.addBindValue(m_user.username);
-    q.addBindValue(id);
-    if (!q.exec()) {
-        QMessageBox::critical(this, tr("错误"), q.lastError().text());
-    }
-    logAudit("activity_approve", QString::number(id), QString("approver=%1").arg(m_user.username));
-    reloadActivities();
-    reloadStats();
+    m_dataService->approveActivity(id, m_user);
 }
 
 void MainWindow::onReject()
 {
-    if (m_user.role != "admin") {
-        QMessageBox::warning(this, tr("权限"), tr("仅管理员可审批"));
-        return;
-    }
     const int id = selectedActivityId(ui->activityTable);
     if (id < 0) return;
-    QSqlQuery q(m_db.database());
-    q.prepare("UPDATE activities SET status='rejected' WHERE id=?");
-    q.addBindValue(id);
-    if (!q.exec()) {
-        QMessageBox::critical(this, tr("错误"), q.lastError().text());
-    }
-    logAudit("activity_reject", QString::number(id));
-    reloadActivities();
+    m_dataService->rejectActivity(id, m_user);
 }
 
 void MainWindow::onDelete()
 {
-    if (m_user.role != "admin") {
-        QMessageBox::warning(this, tr("权限"), tr("仅管理员可删除"));
-        return;
-    }
     const int id = selectedActivityId(ui->activityTable);
     if (id < 0) return;
     if (QMessageBox::question(this, tr("确认"), tr("删除该活动?")) != QMessageBox::Yes) return;
-    QSqlQuery q(m_db.database());
-    q.prepare("DELETE FROM activities WHERE id=?");
-    q.addBindValue(id);
-    q.exec();
-    logAudit("activity_delete", QString::number(id));
-    reloadActivities();
-    reloadEnrollments();
-    reloadStats();
+    m_dataService->deleteActivity(id, m_user);
 }
 
-int MainWindow::selectedActivityId(const QTableView *view) const
+void MainWindow::onActivityActionFinished(const ActionResult &result)
 {
-    const int row = view->currentIndex().row();
-    if (row < 0) return -1;
-    return view->model()->index(row, 0).data().toInt();
+    if (result.action == "activity_submit") {
+        ui->submitActivityButton->setEnabled(true);
+    }
+    if (result.rejected) {
+        QMessageBox::warning(this, tr("提示"), result.error);
+        return;
+    }
+    if (!result.ok) {
+        QMessageBox::critical(this, tr("数据库错误"), result.error);
+        return;
+    }
+    // 列表由 DataService 推送的增量更新，这里只刷新统计
+    if (result.action != "activity_reject") {
+        reloadStats();
+    }
+    if (result.action == "activity_submit") {
+        QMessageBox::information(this, tr("成功"), tr("已提交活动"));
+        ui->titleEdit->setProperty("activityId", QVariant());
+    }
 }
 
-bool MainWindow::hasCapacity(int activityId, int capacity)
+int MainWindow::selectedActivityId(const QTableView *view) const
 {
-    QSqlQuery q(m_db.database());
-    q.prepare("SELECT COUNT(*) FROM enrollments WHERE activity_id=? AND status='active'");
-    q.addBindValue(activityId);
-    q.exec();
-    int cnt = 0;
-    if (q.next()) cnt = q.value(0).toInt();
-    return cnt < capacity;
+    // 按模型缓存的行取主键，不解析显示文本；未加载的行返回 -1
+    const int row = view->currentIndex().row();
+    if (row < 0) return -1;
+    if (auto paged = qobject_cast<const PagedTableModel *>(view->model())) return paged->idForRow(row);
+    if (auto rows = qobject_cast<const RowTableModel *>(view->model())) return rows->idForRow(row);
+    return -1;
 }
 
 void MainWindow::onEnroll()
 {
-    if (m_user.role != "student") {
-        QMessageBox::warning(this, tr("权限"), tr("仅学生可报名"));
-        return;
-    }
     const int id = selectedActivityId(ui->enrollmentActivityTable);
     if (id < 0) return;
+    ui->enrollButton->setEnabled(false);
+    m_dataService->enroll(id, m_user);
+}
 
-    // 检查是否已报名或候补同一活动
-    QSqlQuery check(m_db.database());
-    check.prepare("SELECT status FROM enrollments WHERE activity_id=? AND student=? AND status IN ('active','waiting')");
-    check.addBindValue(id);
-    check.addBindValue(m_user.username);
-    if (check.exec() && check.next()) {
+void MainWindow::onEnrollFinished(const EnrollResult &result)
+{
+    ui->enrollButton->setEnabled(true);
+    switch (result.outcome) {
+    case EnrollResult::Duplicate:
         QMessageBox::information(this, tr("提示"), tr("你已对该活动报名或在候补队列中，不能重复报名/候补"));
         return;
-    }
-
-    // 获取活动时间与容量
-    QSqlQuery info(m_db.database());
-    info.prepare("SELECT start_time,end_time,capacity FROM activities WHERE id=? AND status='approved'");
-    info.addBindValue(id);
-    if (!info.exec() || !info.next()) {
+    case EnrollResult::NotAvailable:
         QMessageBox::warning(this, tr("提示"), tr("活动信息不存在或未审核通过"));
         return;
-    }
-    const QDateTime newStart = QDateTime::fromString(info.value(0).toString(), Qt::ISODate);
-    const QDateTime newEnd = QDateTime::fromString(info.value(1).toString(), Qt::ISODate);
-    const int cap = info.value(2).toInt();
-
-    // 与已报名活动冲突检测（仅比较 active 且未取消的活动）
-    QSqlQuery qConf(m_db.database());
-    qConf.prepare(R"(SELECT a.title, a.start_time, a.end_time
-                     FROM enrollments e
-                     JOIN activities a ON e.activity_id=a.id
-                     WHERE e.student=? AND e.status='active' AND a.status!='cancelled')");
-    qConf.addBindValue(m_user.username);
-    if (!qConf.exec()) {
-        QMessageBox::warning(this, tr("错误"), qConf.lastError().text());
-        return;
-    }
-    QStringList conflicts;
-    while (qConf.next()) {
-        const QString otherTitle = qConf.value(0).toString();
-        const QDateTime s = QDateTime::fromString(qConf.value(1).toString(), Qt::ISODate);
-        const QDateTime e = QDateTime::fromString(qConf.value(2).toString(), Qt::ISODate);
-        if (!(newEnd <= s || newStart >= e)) {
-            conflicts << tr("与活动「%1」时间重叠：%2-%3 与 %4-%5")
-                            .arg(otherTitle,
-                                 s.toString("MM-dd hh:mm"), e.toString("MM-dd hh:mm"),
-                                 newStart.toString("MM-dd hh:mm"), newEnd.toString("MM-dd hh:mm"));
-        }
-    }
-    if (!conflicts.isEmpty()) {
-        QMessageBox::warning(this, tr("时间冲突"), conflicts.join("\n"));
+    case EnrollResult::Conflict:
+        QMessageBox::warning(this, tr("时间冲突"), result.conflicts.join("\n"));
         return;
-    }
-
-    QSqlQuery q(m_db.database());
-    const bool hasSlot = hasCapacity(id, cap);
-    q.prepare("INSERT INTO enrollments(activity_id, student, created_at, status, position) VALUES(?,?,?,?,?)");
-    q.addBindValue(id);
-    q.addBindValue(m_user.username);
-    q.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
-    if (hasSlot) {
-        q.addBindValue("active");
-        q.addBindValue(0);
-    } else {
-        // waitlist
-        QSqlQuery pos(m_db.database());
-        pos.prepare("SELECT COALESCE(MAX(position),0)+1 FROM enrollments WHERE activity_id=? AND status='waiting'");
-        pos.addBindValue(id);
-        pos.exec();
-        int position = 1;
-        if (pos.next()) position = pos.value(0).toInt();
-        q.addBindValue("waiting");
-        q.addBindValue(position);
-    }
-    if (!q.exec()) {
-        QMessageBox::critical(this, tr("错误"), q.lastError().text());
+    case EnrollResult::Failed:
+        QMessageBox::critical(this, tr("错误"), result.error);
         return;
+    case EnrollResult::Enrolled:
+    case EnrollResult::Waitlisted:
+        break;
     }
-    reloadEnrollments();
+    const bool hasSlot = result.outcome == EnrollResult::Enrolled;
     reloadStats();
     QMessageBox::information(this, tr("提示"), hasSlot ? tr("报名成功") : tr("已加入候补队列"));
-    logAudit(hasSlot ? "enroll" : "waitlist", QString::number(id));
 }
 
 void MainWindow::onCancelEnroll()
 {
-    if (m_user.role != "student") {
-        QMessageBox::warning(this, tr("权限"), tr("仅学生可操作报名/候补"));
-        return;
-    }
     const int enrollId = selectedActivityId(ui->waitlistTable);
     if (enrollId < 0) {
         QMessageBox::information(this, tr("提示"), tr("选择候补或报名记录后取消"));
         return;
     }
-    QSqlQuery q(m_db.database());
-    q.prepare("UPDATE enrollments SET status='cancelled' WHERE id=?");
-    q.addBindValue(enrollId);
-    q.exec();
-    // 取消后尝试将候补第1位转正
-    QSqlQuery actIdQ(m_db.database());
-    actIdQ.prepare("SELECT activity_id FROM enrollments WHERE id=?");
-    actIdQ.addBindValue(enrollId);
-    int activityId = -1;
-    if (actIdQ.exec() && actIdQ.next()) activityId = actIdQ.value(0).toInt();
-    if (activityId > 0) {
-        QSqlQuery promote(m_db.database());
-        promote.prepare(R"(SELECT id FROM enrollments 
-                          WHERE activity_id=? AND status='waiting' 
-                          ORDER BY position LIMIT 1)");
-        promote.addBindValue(activityId);
-        if (promote.exec() && promote.next()) {
-            int wid = promote.value(0).toInt();
-            QSqlQuery upd(m_db.database());
-            upd.prepare("UPDATE enrollments SET status='active', position=0 WHERE id=?");
-            upd.addBindValue(wid);
-            upd.exec();
-        }
+    m_dataService->cancelEnrollment(enrollId, m_user);
+}
+
+void MainWindow::onCancelFinished(const CancelResult &result)
+{
+    if (!result.ok) {
+        QMessageBox::critical(this, tr("错误"), result.error);
+        return;
     }
-    logAudit("enroll_cancel", QString::number(enrollId));
-    reloadEnrollments();
     reloadStats();
 }
 
 void MainWindow::onWaitlist()
 {
-    if (m_user.role != "student") {
-        QMessageBox::warning(this, tr("权限"), tr("仅学生可候补"));
-        return;
-    }
     const int id = selectedActivityId(ui->enrollmentActivityTable);
     if (id < 0) return;
+    ui->waitlistButton->setEnabled(false);
+    m_dataService->waitlist(id, m_user);
+}
 
-    // 检查是否已报名或候补同一活动
-    QSqlQuery check(m_db.database());
-    check.prepare("SELECT status FROM enrollments WHERE activity_id=? AND student=? AND status IN ('active','waiting')");
-    check.addBindValue(id);
-    check.addBindValue(m_user.username);
-    if (check.exec() && check.next()) {
+void MainWindow::onWaitlistFinished(const EnrollResult &result)
+{
+    ui->waitlistButton->setEnabled(true);
+    if (result.outcome == EnrollResult::Duplicate) {
         QMessageBox::information(this, tr("提示"), tr("你已对该活动报名或在候补队列中，不能重复候补"));
         return;
     }
-
-    QSqlQuery pos(m_db.database());
-    pos.prepare("SELECT COALESCE(MAX(position),0)+1 FROM enrollments WHERE activity_id=? AND status='waiting'");
-    pos.addBindValue(id);
-    pos.exec();
-    int position = 1;
-    if (pos.next()) position = pos.value(0).toInt();
-
-    QSqlQuery q(m_db.database());
-    q.prepare("INSERT INTO enrollments(activity_id, student, created_at, status, position) VALUES(?,?,?,?,?)");
-    q.addBindValue(id);
-    q.addBindValue(m_user.username);
-    q.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
-    q.addBindValue("waiting");
-    q.addBindValue(position);
-    q.exec();
-    logAudit("waitlist", QString::number(id), QString("position=%1").arg(position));
-    reloadEnrollments();
-    QMessageBox::information(this, tr("候补"), tr("已加入候补，第 %1 位").arg(position));
+    if (result.outcome != EnrollResult::Waitlisted) {
+        QMessageBox::critical(this, tr("错误"), result.error);
+        return;
+    }
+    QMessageBox::information(this, tr("候补"), tr("已加入候补，第 %1 位").arg(result.position));
 }
 
 void MainWindow::onCheckConflict()
@@ -599,31 +516,14 @@ void MainWindow::onCheckConflict()
     if (m_user.role != "student") {
         return;
     }
-    QSqlQuery q(m_db.database());
-    q.prepare(R"(SELECT a.title, a.start_time, a.end_time
-              FROM enrollments e
-              JOIN activities a ON e.activity_id=a.id
-              WHERE e.student=? AND e.status='active' AND a.status!='cancelled'
-              ORDER BY a.start_time)");
-    q.addBindValue(m_user.username);
-    q.exec();
-    struct Item { QString title; QDateTime start; QDateTime end; };
-    QList<Item> items;
-    QStringList conflicts;
-    while (q.next()) {
-        Item cur { q.value(0).toString(),
-                   QDateTime::fromString(q.value(1).toString(), Qt::ISODate),
-                   QDateTime::fromString(q.value(2).toString(), Qt::ISODate) };
-        for (const auto &it : items) {
-            if (!(cur.end <= it.start || cur.start >= it.end)) {
-                conflicts << tr("活动「%1」(%2-%3) 与 「%4」(%5-%6) 时间冲突")
-                                .arg(it.title,
-                                     it.start.toString("MM-dd hh:mm"), it.end.toString("MM-dd hh:mm"),
-                                     cur.title,
-                                     cur.start.toString("MM-dd hh:mm"), cur.end.toString("MM-dd hh:mm"));
-            }
-        }
-        items.append(cur);
+    m_dataService->checkStudentConflicts(m_user.username);
+}
+
+void MainWindow::onStudentConflictsLoaded(const QStringList &conflicts, const QString &error)
+{
+    if (!error.isEmpty()) {
+        QMessageBox::critical(this, tr("错误"), error);
+        return;
     }
     QMessageBox::information(this, tr("冲突检查"),
                              conflicts.isEmpty() ? tr("无冲突") : conflicts.join('\n'));
@@ -631,57 +531,28 @@ void MainWindow::onCheckConflict()
 
 void MainWindow::onExportMyEnroll()
 {
-    if (m_user.role != "student") {
-        QMessageBox::warning(this, tr("权限"), tr("仅学生可导出自己的报名"));
-        return;
-    }
-    QSqlQuery q(m_db.database());
-    q.prepare(R"(SELECT a.title, a.start_time, a.end_time, e.status
-                FROM enrollments e
-                JOIN activities a ON e.activity_id=a.id
-                WHERE e.student=?)");
-    q.addBindValue(m_user.username);
-    q.exec();
-    QVector<QStringList> rows;
-    rows << QStringList{ "标题", "开始", "结束", "状态" };
-    while (q.next()) {
-        rows << QStringList{ q.value(0).toString(), q.value(1).toString(), q.value(2).toString(), q.value(3).toString() };
-    }
     const QString path = QFileDialog::getSaveFileName(this, tr("导出 CSV"), QDir::homePath() + "/my_enroll.csv", "CSV (*.csv)");
     if (path.isEmpty()) return;
-    QString err;
-    if (CsvExporter::write(path, rows, &err)) {
-        QMessageBox::information(this, tr("导出"), tr("已导出到 %1").arg(path));
-        logAudit("export_my_enroll", path);
-    } else {
-        QMessageBox::critical(this, tr("导出失败"), err);
-    }
+    ui->exportMyEnrollButton->setEnabled(false);
+    m_dataService->exportMyEnrollments(path, m_user);
 }
 
 void MainWindow::onExportCsv()
 {
-    if (m_user.role == "student") {
-        QMessageBox::warning(this, tr("权限"), tr("仅管理员/发起人可导出报名列表"));
-        return;
-    }
-    QSqlQuery q(m_db.database());
-    q.exec(R"(SELECT a.title, e.student, e.status, e.position
-              FROM enrollments e
-              JOIN activities a ON e.activity_id=a.id
-              ORDER BY a.title, e.status)");
-    QVector<QStringList> rows;
-    rows << QStringList{ "活动", "学生", "状态", "候补序号" };
-    while (q.next()) {
-        rows << QStringList{ q.value(0).toString(), q.value(1).toString(), q.value(2).toString(), q.value(3).toString() };
-    }
     const QString path = QFileDialog::getSaveFileName(this, tr("导出 CSV"), QDir::homePath() + "/enrollments.csv", "CSV (*.csv)");
     if (path.isEmpty()) return;
-    QString err;
-    if (CsvExporter::write(path, rows, &err)) {
-        QMessageBox::information(this, tr("导出"), tr("已导出到 %1").arg(path));
-        logAudit("export_enrollments", path);
+    ui->exportCsvButton->setEnabled(false);
+    m_dataService->exportEnrollments(path, m_user);
+}
+
+void MainWindow::onExportFinished(const ActionResult &result)
+{
+    const bool mine = result.action == "export_my_enroll";
+    (mine ? ui->exportMyEnrollButton : ui->exportCsvButton)->setEnabled(true);
+    if (result.ok) {
+        QMessageBox::information(this, tr("导出"), tr("已导出到 %1").arg(result.target));
     } else {
-        QMessageBox::critical(this, tr("失败"), err);
+        QMessageBox::critical(this, mine ? tr("导出失败") : tr("失败"), result.error);
     }
 }
 
@@ -689,25 +560,97 @@ void MainWindow::onRunReport()
 {
     ui->reportStatusLabel->setText(tr("状态: 生成中..."));
     ui->runReportButton->setEnabled(false);
-    QMetaObject::invokeMethod(m_reportWorker, "generateReport", Qt::QueuedConnection);
-    QMetaObject::invokeMethod(m_reportWorker, "checkConflicts", Qt::QueuedConnection);
+    ui->cancelReportButton->setEnabled(true);
+    m_conflictRecords.clear();
+    m_reportJobsStarted = 0;
+    m_reportJobsDone = 0;
+    m_reportWorker->startReport();
     logAudit("report_generate");
 }
 
-void MainWindow::onReportFinished(const QString &path)
+void MainWindow::onCancelReport()
 {
-    ui->reportStatusLabel->setText(tr("状态: 完成"));
+    // 工作线程阻塞在 generateReport 中，取消请求直接置位而不走事件队列
+    m_reportWorker->cancel();
+    ui->cancelReportButton->setEnabled(false);
+    ui->reportStatusLabel->setText(tr("状态: 正在取消..."));
+    logAudit("report_cancel");
+}
+
+void MainWindow::onReportJobProgress(const QString &name, qint64 done, qint64 total, qint64 etaMs)
+{
+    Q_UNUSED(name);
+    if (!ui->cancelReportButton->isEnabled()) return; // 取消中不再刷新
+    QString text = total > 0
+            ? tr("状态: 生成中 %1/%2，当前作业 %3/%4 行").arg(m_reportJobsDone).arg(m_reportJobsStarted).arg(done).arg(total)
+            : tr("状态: 生成中 %1/%2，当前作业 %3 行").arg(m_reportJobsDone).arg(m_reportJobsStarted).arg(done);
+    if (etaMs > 0) text += tr("，预计剩余 %1 秒").arg((etaMs + 999) / 1000);
+    ui->reportStatusLabel->setText(text);
+}
+
+void MainWindow::onReportJobStarted(const QString &name, const QString &title)
+{
+    Q_UNUSED(name);
+    ++m_reportJobsStarted;
+    if (!ui->cancelReportButton->isEnabled()) return;
+    ui->reportStatusLabel->setText(tr("状态: 生成中 %1/%2（%3）").arg(m_reportJobsDone).arg(m_reportJobsStarted).arg(title));
+}
+
+void MainWindow::onReportJobFinished(const ReportJobResult &result)
+{
+    ++m_reportJobsDone;
+    if (!ui->cancelReportButton->isEnabled()) return;
+    ui->reportStatusLabel->setText(tr("状态: 生成中 %1/%2（%3 完成，%4 ms）")
+                                   .arg(m_reportJobsDone).arg(m_reportJobsStarted).arg(result.title).arg(result.elapsedMs));
+}
+
+void MainWindow::onReportFinished(const QString &dir, const QVector<ReportJobResult> &results, qint64 elapsedMs)
+{
+    const bool wasCancelled = std::any_of(results.cbegin(), results.cend(),
+                                          [](const ReportJobResult &r) { return r.cancelled; });
+    ui->reportStatusLabel->setText(wasCancelled ? tr("状态: 已取消（%1 ms）").arg(elapsedMs)
+                                                : tr("状态: 完成（%1 ms）").arg(elapsedMs));
     ui->runReportButton->setEnabled(true);
-    if (path.startsWith("导出失败")) {
-        QMessageBox::critical(this, tr("报表"), path);
+    ui->cancelReportButton->setEnabled(false);
+    QStringList lines;
+    bool failed = false;
+    for (const ReportJobResult &r : results) {
+        if (r.cancelled) {
+            lines << tr("%1：已取消").arg(r.title);
+        } else if (r.ok) {
+            lines << tr("%1：%2 行，%3 ms").arg(r.title).arg(r.rows).arg(r.elapsedMs);
+        } else {
+            failed = true;
+            lines << tr("%1：失败 %2").arg(r.title, r.error);
+        }
+    }
+    lines << tr("总耗时 %1 ms，输出目录: %2").arg(elapsedMs).arg(dir);
+    if (failed) {
+        QMessageBox::warning(this, tr("报表"), lines.join('\n'));
     } else {
-        QMessageBox::information(this, tr("报表"), tr("报表已生成: %1").arg(path));
+        QMessageBox::information(this, tr("报表"), lines.join('\n'));
     }
 }
 
-void MainWindow::onConflictResult(const QString &result)
+void MainWindow::onConflictsFound(const QVector<ConflictRecord> &records)
+{
+    m_conflictRecords += records;
+}
+
+void MainWindow::onConflictCheckFinished(int total)
 {
-    QMessageBox::information(this, tr("全局冲突检查"), result);
+    if (total == 0) {
+        QMessageBox::information(this, tr("全局冲突检查"), tr("未发现时间冲突"));
+        return;
+    }
+    // 冲突可能很多，对话框只展示前若干条
+    const int shown = qMin(int(m_conflictRecords.size()), 50);
+    QStringList lines;
+    for (int i = 0; i < shown; ++i) {
+        lines << m_conflictRecords.at(i).describe();
+    }
+    if (total > shown) lines << tr("……共 %1 条冲突").arg(total);
+    QMessageBox::information(this, tr("全局冲突检查"), lines.join('\n'));
 }
 
 void MainWindow::onLogout()
@@ -718,13 +661,7 @@ void MainWindow::onLogout()
 
 void MainWindow::logAudit(const QString &action, const QString &target, const QString &detail)
 {
-    QSqlQuery q(m_db.database());
-    q.prepare("INSERT INTO audit_logs(action, actor, target, detail, created_at) VALUES(?,?,?,?,?)");
-    q.addBindValue(action);
-    q.addBindValue(m_user.username);
-    q.addBindValue(target);
-    q.addBindValue(detail);
-    q.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
-    q.exec();
+    // 入队即返回，由后台线程批量写入
+    AuditSink::instance().log(action, m_user.username, target, detail);
 }
 
@@ -1,17 +1,17 @@
 #pragma once
 
 #include <QMainWindow>
-#include <QSqlTableModel>
 #include <QItemSelection>
-#include <QSqlQueryModel>
 #include <QTableView>
 #include <QThread>
-#include "dbmanager.h"
+#include <QTimer>
+#include "campuscore.h"
+#include "dataservice.h"
 #include "models/activitymodel.h"
+#include "models/auditlogmodel.h"
 #include "models/enrollmentmodel.h"
 #include "networkservice.h"
 #include "reportworker.h"
-#include "utils/csvexporter.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -33,6 +33,7 @@ private slots:
     void reloadActivities();
     void reloadEnrollments();
     void reloadStats();
+    void reloadAuditLog();
 
     void onActivitySelected(const QItemSelection &selected);
     void onSubmitActivity();
@@ -48,29 +49,49 @@ private slots:
 
     void onExportCsv();
     void onRunReport();
-    void onReportFinished(const QString &path);
-    void onConflictResult(const QString &result);
+    void onCancelReport();
+    void onReportJobStarted(const QString &name, const QString &title);
+    void onReportJobProgress(const QString &name, qint64 done, qint64 total, qint64 etaMs);
+    void onReportJobFinished(const ReportJobResult &result);
+    void onReportFinished(const QString &dir, const QVector<ReportJobResult> &results, qint64 elapsedMs);
+    void onConflictsFound(const QVector<ConflictRecord> &records);
+    void onConflictCheckFinished(int total);
     void onLogout();
+    void onEnrollFinished(const EnrollResult &result);
+    void onWaitlistFinished(const EnrollResult &result);
+    void onCancelFinished(const CancelResult &result);
+    void onActivityActionFinished(const ActionResult &result);
+    void onStudentConflictsLoaded(const QStringList &conflicts, const QString &error);
+    void onExportFinished(const ActionResult &result);
+    void onStatsLoaded(const DashboardStats &stats);
     void logAudit(const QString &action, const QString &target = QString(), const QString &detail = QString());
 
 private:
     void setupUiState();
     void bindModels();
     void fillFormFromSelection();
-    bool saveActivity(bool isNew);
+    void saveActivity(bool isNew);
     int selectedActivityId(const QTableView *view) const;
-    bool hasCapacity(int activityId, int capacity);
 
     Ui::MainWindow *ui;
     UserInfo m_user;
-    DbManager m_db;
     ActivityModel *m_activityModel;
+    AuditLogModel *m_auditModel { nullptr };
     EnrollmentModel *m_enrollmentModel;
     EnrollmentModel *m_waitlistModel;
-    QSqlQueryModel *m_upcomingModel;
-    QSqlQueryModel *m_reportPreviewModel;
+    RowTableModel *m_upcomingModel;
+    RowTableModel *m_reportPreviewModel;
     QThread m_workerThread;
     ReportWorker *m_reportWorker;
+    QVector<ConflictRecord> m_conflictRecords;
+    int m_reportJobsStarted { 0 };
+    int m_reportJobsDone { 0 };
+    QThread m_dataThread;
+    DataService *m_dataService;
     NetworkService m_network;
+    QTimer m_filterDebounce;
+    ActivityFilter m_lastActivityFilter;
+    bool m_activityFilterLoaded { false };
+    quint64 m_statsVersion { 0 }; // 已显示的统计快照版本
 };
 
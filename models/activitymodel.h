@@ -1,12 +1,12 @@
 #pragma once
 
-#include <QSqlTableModel>
+#include "pagedtablemodel.h"
 
-class ActivityModel : public QSqlTableModel
+// 活动列表，列顺序与 activities 表一致：id,title,category,location,start_time,end_time,capacity,approver,status,creator
+// 按页加载，只有带索引的列可排序
+class ActivityModel : public PagedTableModel
 {
     Q_OBJECT
 public:
-    explicit ActivityModel(QObject *parent, const QSqlDatabase &db);
-    void applyFilter(const QString &role, const QString &username, const QString &category, const QString &status, const QString &keyword);
+    explicit ActivityModel(QObject *parent = nullptr);
 };
-
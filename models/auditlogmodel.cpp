@@ -0,0 +1,12 @@
+#include "auditlogmodel.h"
+
+AuditLogModel::AuditLogModel(QObject *parent)
+    : PagedTableModel(200, 8, parent)
+{
+    setHeaderData(0, Qt::Horizontal, tr("ID"));
+    setHeaderData(1, Qt::Horizontal, tr("时间"));
+    setHeaderData(2, Qt::Horizontal, tr("操作人"));
+    setHeaderData(3, Qt::Horizontal, tr("操作"));
+    setHeaderData(4, Qt::Horizontal, tr("对象"));
+    setHeaderData(5, Qt::Horizontal, tr("详情"));
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "pagedtablemodel.h"
+
+// 审计日志列表：id,created_at,actor,action,target,detail，按时间倒序分页
+class AuditLogModel : public PagedTableModel
+{
+    Q_OBJECT
+public:
+    explicit AuditLogModel(QObject *parent = nullptr);
+};
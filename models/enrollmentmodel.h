@@ -1,19 +1,11 @@
 #pragma once
 
-#include <QSqlQueryModel>
-#include <QSqlDatabase>
+#include "rowtablemodel.h"
 
-class EnrollmentModel : public QSqlQueryModel
+// 学生端的可报名活动 / 我的报名列表，表头取自 DataService 查询中的列别名
+class EnrollmentModel : public RowTableModel
 {
     Q_OBJECT
 public:
-    explicit EnrollmentModel(QObject *parent = nullptr, const QSqlDatabase &db = QSqlDatabase());
-
-    void loadAvailableActivities();
-    void loadMyEnrollments(const QString &student, bool waitingOnly = false);
-    int idForRow(int row) const;
-
-private:
-    QSqlDatabase m_db;
+    explicit EnrollmentModel(QObject *parent = nullptr);
 };
-
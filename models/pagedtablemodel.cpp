@@ -0,0 +1,242 @@
+#include "pagedtablemodel.h"
+
+#include <QAtomicInteger>
+#include <QDebug>
+#include <cstdlib>
+
+namespace {
+// 多个模型共用 DataService 的 pageLoaded 信号，代号全局唯一才能区分各自的结果
+QAtomicInteger<quint64> g_generation;
+}
+
+PagedTableModel::PagedTableModel(int pageSize, int maxPages, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_pageSize(qMax(1, pageSize))
+    , m_maxPages(qMax(3, maxPages))
+{
+}
+
+void PagedTableModel::setQuery(const PageQuery &query)
+{
+    beginResetModel();
+    m_query = query;
+    m_total = 0;
+    m_loaded = false;
+    m_pages.clear();
+    m_pageEnds.clear();
+    m_pending.clear();
+    endResetModel();
+    m_generation = ++g_generation;
+    requestPage(0, true);
+}
+
+void PagedTableModel::setSortKey(int column, const QString &sortKey)
+{
+    m_sortKeys.insert(column, sortKey);
+}
+
+void PagedTableModel::applySort(PageQuery *query) const
+{
+    if (m_sortColumn < 0) return;
+    query->sortKey = m_sortKeys.value(m_sortColumn);
+    query->descending = m_sortOrder == Qt::DescendingOrder;
+}
+
+void PagedTableModel::sort(int column, Qt::SortOrder order)
+{
+    // 只允许按登记过（有索引）的列排序，-1 恢复查询自带顺序
+    if (column >= 0 && !m_sortKeys.contains(column)) return;
+    if (column == m_sortColumn && order == m_sortOrder) return;
+    m_sortColumn = column;
+    m_sortOrder = order;
+    if (!m_loaded && m_pending.isEmpty()) return; // 尚未设置查询
+    refresh();
+}
+
+void PagedTableModel::refresh()
+{
+    // 丢弃缓存与 keyset 锚点，重新计数；可见行在视图重绘时按需重新请求
+    m_generation = ++g_generation;
+    m_pages.clear();
+    m_pageEnds.clear();
+    m_pending.clear();
+    requestPage(0, true);
+}
+
+void PagedTableModel::requestPage(int page, bool withTotal) const
+{
+    if (page < 0 || m_pending.contains(page)) return;
+    if (!withTotal && m_pages.contains(page)) return;
+    PageRequest req;
+    req.generation = m_generation;
+    req.page = page;
+    req.pageSize = m_pageSize;
+    req.withTotal = withTotal;
+    req.query = m_query;
+    applySort(&req.query);
+    const auto anchor = m_pageEnds.constFind(page - 1);
+    if (page > 0 && anchor != m_pageEnds.constEnd()) {
+        req.hasAnchor = true;
+        req.anchorKey = anchor->first;
+        req.anchorId = anchor->second;
+    }
+    m_pending.insert(page);
+    emit const_cast<PagedTableModel *>(this)->pageRequested(req);
+}
+
+void PagedTableModel::onPageLoaded(const PageResult &result)
+{
+    if (result.generation != m_generation) return; // 已被新查询或排序取代
+    m_pending.remove(result.page);
+    if (!result.error.isEmpty()) {
+        qWarning() << "PagedTableModel: page" << result.page << "failed:" << result.error;
+        return;
+    }
+
+    // 最后一列是排序键，只用于记录本页末行作为下一页的 keyset 锚点
+    Page page;
+    page.lastUsed = ++m_tick;
+    page.rows.reserve(result.rows.rows.size());
+    for (QVariantList row : result.rows.rows) {
+        const QVariant key = row.isEmpty() ? QVariant() : row.takeLast();
+        if (!row.isEmpty()) m_pageEnds.insert(result.page, qMakePair(key, row.first()));
+        page.rows << row;
+    }
+    m_pages.insert(result.page, page);
+    evictFar(result.page);
+
+    if (result.total >= 0) {
+        if (!m_loaded) {
+            beginResetModel();
+            if (!m_presetHeaders) {
+                m_headers = result.rows.columns;
+                if (!m_headers.isEmpty()) m_headers.removeLast();
+            }
+            m_total = result.total;
+            m_loaded = true;
+            endResetModel();
+            return;
+        }
+        if (result.total > m_total) {
+            beginInsertRows(QModelIndex(), m_total, result.total - 1);
+            m_total = result.total;
+            endInsertRows();
+        } else if (result.total < m_total) {
+            beginRemoveRows(QModelIndex(), result.total, m_total - 1);
+            m_total = result.total;
+            endRemoveRows();
+        }
+        // 刷新后的首个结果：整体标脏，视图只会重新取可见行
+        if (m_total > 0) emit dataChanged(index(0, 0), index(m_total - 1, columnCount() - 1));
+        return;
+    }
+    const int first = result.page * m_pageSize;
+    const int last = qMin(m_total, first + int(page.rows.size())) - 1;
+    if (last >= first) emit dataChanged(index(first, 0), index(last, columnCount() - 1));
+}
+
+void PagedTableModel::evictFar(int center)
+{
+    // 淘汰离当前页最远的页；keyset 锚点体积很小，保留以便回滚时直接定位
+    while (m_pages.size() > m_maxPages) {
+        int victim = -1;
+        for (auto it = m_pages.cbegin(); it != m_pages.cend(); ++it) {
+            if (victim < 0 || std::abs(it.key() - center) > std::abs(victim - center)
+                    || (std::abs(it.key() - center) == std::abs(victim - center)
+                        && it->lastUsed < m_pages.value(victim).lastUsed)) {
+                victim = it.key();
+            }
+        }
+        m_pages.remove(victim);
+    }
+}
+
+const QVariantList *PagedTableModel::rowAt(int row) const
+{
+    if (row < 0 || row >= m_total) return nullptr;
+    const int pageNo = row / m_pageSize;
+    const int offset = row % m_pageSize;
+    auto it = m_pages.find(pageNo);
+    if (it == m_pages.end()) {
+        requestPage(pageNo);
+        return nullptr;
+    }
+    it->lastUsed = ++m_tick;
+    // 接近页尾时预取下一页，滚动时不出现空白
+    if (offset >= m_pageSize * 3 / 4 && (pageNo + 1) * m_pageSize < m_total) requestPage(pageNo + 1);
+    return offset < it->rows.size() ? &it->rows.at(offset) : nullptr;
+}
+
+void PagedTableModel::applyPatch(const RowPatch &patch)
+{
+    if (!m_loaded) return;
+    QHash<int, int> fresh;
+    for (int i = 0; i < patch.rows.rows.size(); ++i) {
+        const QVariantList &row = patch.rows.rows.at(i);
+        if (!row.isEmpty()) fresh.insert(row.first().toInt(), i);
+    }
+    bool structural = false;
+    for (int id : patch.ids) {
+        bool cached = false;
+        for (auto it = m_pages.begin(); it != m_pages.end() && !cached; ++it) {
+            for (int i = 0; i < it->rows.size(); ++i) {
+                if (it->rows.at(i).value(0).toInt() != id) continue;
+                cached = true;
+                const auto f = fresh.constFind(id);
+                if (f == fresh.constEnd()) {
+                    structural = true;
+                } else {
+                    it->rows[i] = patch.rows.rows.at(f.value());
+                    const int row = it.key() * m_pageSize + i;
+                    emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+                }
+                break;
+            }
+        }
+        // 未缓存的行无法判断是新增还是窗口外的修改，按结构变化处理
+        if (!cached && fresh.contains(id)) structural = true;
+    }
+    if (structural) refresh();
+}
+
+int PagedTableModel::idForRow(int row) const
+{
+    const QVariantList *r = rowAt(row);
+    return r && !r->isEmpty() ? r->first().toInt() : -1;
+}
+
+int PagedTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_total;
+}
+
+int PagedTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_headers.size();
+}
+
+QVariant PagedTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::EditRole)) return QVariant();
+    const QVariantList *row = rowAt(index.row());
+    if (!row) return role == Qt::DisplayRole ? QVariant(QStringLiteral("…")) : QVariant();
+    return index.column() < row->size() ? row->at(index.column()) : QVariant();
+}
+
+QVariant PagedTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section >= 0 && section < m_headers.size()) {
+        return m_headers.at(section);
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+bool PagedTableModel::setHeaderData(int section, Qt::Orientation orientation, const QVariant &value, int role)
+{
+    if (orientation != Qt::Horizontal || role != Qt::EditRole || section < 0) return false;
+    while (m_headers.size() <= section) m_headers << QString();
+    m_headers[section] = value.toString();
+    m_presetHeaders = true;
+    emit headerDataChanged(orientation, section, section);
+    return true;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "rowtablemodel.h"
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+// 分页查询定义：SELECT <columns> FROM <from> [WHERE <where>] ORDER BY <sortKey>, <idColumn>
+// sortKey 应为有索引的列，翻页用 keyset（上一页最后一行的排序键与 id）定位，不随页号变慢
+struct PageQuery {
+    QString columns;  // 第 0 列须为主键
+    QString from;     // 表名，可带 JOIN
+    QString where;    // 不含 WHERE 关键字
+    QVariantList binds;
+    QString sortKey { "id" };
+    bool descending { false };
+    QString idColumn { "id" };
+};
+Q_DECLARE_METATYPE(PageQuery)
+
+struct PageRequest {
+    quint64 generation { 0 };
+    int page { 0 };
+    int pageSize { 0 };
+    bool withTotal { false };
+    // keyset 锚点：有上一页末行时使用，否则退回 OFFSET（仅在跳页时发生）
+    bool hasAnchor { false };
+    QVariant anchorKey;
+    QVariant anchorId;
+    PageQuery query;
+};
+Q_DECLARE_METATYPE(PageRequest)
+
+struct PageResult {
+    quint64 generation { 0 };
+    int page { 0 };
+    int total { -1 };  // 仅 withTotal 请求返回
+    QueryRows rows;    // 最后一列为排序键，不显示
+    QString error;
+};
+Q_DECLARE_METATYPE(PageResult)
+
+// 窗口化的只读表格模型：只缓存视图访问过的页（含相邻预取页），超过上限时淘汰离当前位置最远的页。
+// 数据由外部（DataService）按 pageRequested 异步查询后经 onPageLoaded 送回，UI 线程不访问数据库。
+class PagedTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    explicit PagedTableModel(int pageSize = 200, int maxPages = 8, QObject *parent = nullptr);
+
+    // 切换查询：清空缓存并请求首页与总数
+    void setQuery(const PageQuery &query);
+    // 允许排序的列及其排序表达式（应有索引）；未登记的列不可排序
+    void setSortKey(int column, const QString &sortKey);
+
+    void applyPatch(const RowPatch &patch);
+    // 行所在页已缓存时返回第 0 列主键，否则返回 -1 并请求该页（显示为 "…" 的行不能当作 ID 使用）
+    int idForRow(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool setHeaderData(int section, Qt::Orientation orientation, const QVariant &value, int role = Qt::EditRole) override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+public slots:
+    void onPageLoaded(const PageResult &result);
+
+signals:
+    void pageRequested(const PageRequest &request);
+
+private:
+    struct Page {
+        QVector<QVariantList> rows;
+        quint64 lastUsed { 0 };
+    };
+
+    const QVariantList *rowAt(int row) const;
+    void requestPage(int page, bool withTotal = false) const;
+    void applySort(PageQuery *query) const;
+    void refresh();
+    void evictFar(int center);
+
+    PageQuery m_query;
+    QHash<int, QString> m_sortKeys;
+    int m_sortColumn { -1 }; // 用户点选的排序列，-1 表示沿用查询自带的顺序
+    Qt::SortOrder m_sortOrder { Qt::AscendingOrder };
+    int m_pageSize;
+    int m_maxPages;
+    int m_total { 0 };
+    bool m_loaded { false };
+    QStringList m_headers;
+    bool m_presetHeaders { false };
+
+    // data() 为 const，缓存与请求状态需 mutable
+    mutable quint64 m_generation { 0 };
+    mutable quint64 m_tick { 0 };
+    mutable QHash<int, Page> m_pages;
+    mutable QHash<int, QPair<QVariant, QVariant>> m_pageEnds; // 页号 -> 末行 (排序键, id)
+    mutable QSet<int> m_pending;
+};
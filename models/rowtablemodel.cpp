@@ -0,0 +1,98 @@
+#include "rowtablemodel.h"
+
+RowTableModel::RowTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void RowTableModel::setRows(const QueryRows &rows)
+{
+    beginResetModel();
+    // 子类通过 setHeaderData 预设的表头优先，否则使用查询列名（SQL 别名）
+    if (!m_presetHeaders) {
+        m_headers = rows.columns;
+    }
+    m_rows = rows.rows;
+    rebuildIdIndex();
+    endResetModel();
+}
+
+void RowTableModel::applyPatch(const RowPatch &patch)
+{
+    // 尚未整体加载过时忽略，等待首次 setRows
+    if (m_headers.isEmpty()) return;
+    QHash<int, int> fresh;
+    for (int i = 0; i < patch.rows.rows.size(); ++i) {
+        const QVariantList &row = patch.rows.rows.at(i);
+        if (!row.isEmpty()) fresh.insert(row.first().toInt(), i);
+    }
+    for (int id : patch.ids) {
+        const int row = rowForId(id);
+        const auto it = fresh.constFind(id);
+        if (row >= 0 && it != fresh.constEnd()) {
+            m_rows[row] = patch.rows.rows.at(it.value());
+            emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+        } else if (row >= 0) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_rows.remove(row);
+            rebuildIdIndex();
+            endRemoveRows();
+        } else if (it != fresh.constEnd()) {
+            const int at = m_rows.size();
+            beginInsertRows(QModelIndex(), at, at);
+            m_rows << patch.rows.rows.at(it.value());
+            m_rowById.insert(id, at);
+            endInsertRows();
+        }
+    }
+}
+
+int RowTableModel::idForRow(int row) const
+{
+    if (row < 0 || row >= m_rows.size() || m_rows.at(row).isEmpty()) return -1;
+    return m_rows.at(row).first().toInt();
+}
+
+void RowTableModel::rebuildIdIndex()
+{
+    m_rowById.clear();
+    m_rowById.reserve(m_rows.size());
+    for (int i = 0; i < m_rows.size(); ++i) {
+        if (!m_rows.at(i).isEmpty()) m_rowById.insert(m_rows.at(i).first().toInt(), i);
+    }
+}
+
+int RowTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int RowTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_headers.size();
+}
+
+QVariant RowTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::EditRole)) return QVariant();
+    const QVariantList &row = m_rows.at(index.row());
+    return index.column() < row.size() ? row.at(index.column()) : QVariant();
+}
+
+QVariant RowTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section >= 0 && section < m_headers.size()) {
+        return m_headers.at(section);
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+bool RowTableModel::setHeaderData(int section, Qt::Orientation orientation, const QVariant &value, int role)
+{
+    if (orientation != Qt::Horizontal || role != Qt::EditRole || section < 0) return false;
+    while (m_headers.size() <= section) m_headers << QString();
+    m_headers[section] = value.toString();
+    m_presetHeaders = true;
+    emit headerDataChanged(orientation, section, section);
+    return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <QVariantList>
+#include <QVector>
+
+// 后台线程查询得到的结果集，按值传递给 UI 线程
+struct QueryRows {
+    QStringList columns;
+    QVector<QVariantList> rows;
+};
+Q_DECLARE_METATYPE(QueryRows)
+
+// 增量更新：ids 为受影响的主键（第 0 列），rows 为这些主键中仍满足查询条件的最新行；
+// ids 中不在 rows 里的行应从模型中移除
+struct RowPatch {
+    QList<int> ids;
+    QueryRows rows;
+};
+Q_DECLARE_METATYPE(RowPatch)
+
+// 只读表格模型：数据由 DataService 在后台查询好后整体灌入，UI 线程不再访问数据库
+class RowTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    explicit RowTableModel(QObject *parent = nullptr);
+
+    void setRows(const QueryRows &rows);
+    // 只改动受影响的行（dataChanged / rowsInserted / rowsRemoved），保留选择与滚动位置
+    void applyPatch(const RowPatch &patch);
+    int idForRow(int row) const;
+    int rowForId(int id) const { return m_rowById.value(id, -1); }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool setHeaderData(int section, Qt::Orientation orientation, const QVariant &value, int role = Qt::EditRole) override;
+
+protected:
+    void rebuildIdIndex();
+
+    QStringList m_headers;
+    QHash<int, int> m_rowById;
+    QVector<QVariantList> m_rows;
+    bool m_presetHeaders { false };
+};
@@ -1,106 +1,296 @@
 #include "reportworker.h"
-#include "utils/csvexporter.h"
+#include "connectionpool.h"
+#include "dbmanager.h"
+#include "utils/csvwriter.h"
 
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QStandardPaths>
 #include <QDateTime>
-#include <QFileInfo>
 #include <QDir>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QThread>
 #include <QStringList>
 #include <QVariant>
+#include <QPair>
+#include <algorithm>
+#include <utility>
+
+namespace {
+// 限制进度信号频率并按已用时间线性估算剩余时间
+class ProgressThrottle
+{
+public:
+    explicit ProgressThrottle(qint64 total) : m_total(total) { m_timer.start(); }
+
+    // 距上次上报不足间隔时返回 false
+    bool due()
+    {
+        if (m_lastEmit >= 0 && m_timer.elapsed() - m_lastEmit < kIntervalMs) return false;
+        m_lastEmit = m_timer.elapsed();
+        return true;
+    }
+
+    qint64 etaMs(qint64 done) const
+    {
+        if (done <= 0 || m_total <= done) return done > 0 && m_total > 0 ? 0 : -1;
+        return m_timer.elapsed() * (m_total - done) / done;
+    }
+
+    qint64 total() const { return m_total; }
+
+private:
+    static constexpr qint64 kIntervalMs = 200;
+    QElapsedTimer m_timer;
+    qint64 m_total;
+    qint64 m_lastEmit { -1 };
+};
+}
 
 ReportWorker::ReportWorker(QObject *parent)
     : QObject(parent)
+    , m_pool(this)
 {
+    qRegisterMetaType<QVector<ConflictRecord>>("QVector<ConflictRecord>");
+    qRegisterMetaType<ReportJobResult>("ReportJobResult");
+    qRegisterMetaType<QVector<ReportJobResult>>("QVector<ReportJobResult>");
+    // 每个作业占用一个池化连接，并发数需给界面和数据服务留出名额
+    m_pool.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), 4));
 }
 
-void ReportWorker::setDatabase(const QSqlDatabase &db)
+ReportWorker::~ReportWorker()
 {
-    m_dbPath = db.databaseName();
-    m_connName = QString("worker-%1").arg(reinterpret_cast<quintptr>(this));
+    cancel();
+    m_pool.waitForDone();
 }
 
-QSqlDatabase ReportWorker::openDb()
+void ReportWorker::cancel()
 {
-    if (QSqlDatabase::contains(m_connName)) {
-        return QSqlDatabase::database(m_connName);
-    }
-    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_connName);
-    db.setDatabaseName(m_dbPath);
-    db.open();
-    return db;
+    m_cancel.storeRelaxed(1);
+    m_pool.clear();
 }
 
-void ReportWorker::generateReport()
+void ReportWorker::startReport()
 {
-    QSqlDatabase db = openDb();
-    if (!db.isOpen()) return;
+    m_cancel.storeRelaxed(0);
+    QMetaObject::invokeMethod(this, "generateReport", Qt::QueuedConnection);
+}
+
+void ReportWorker::waitForJobs()
+{
+    m_pool.waitForDone();
+}
+
+qint64 ReportWorker::countRows(const QSqlDatabase &db, const QString &sql) const
+{
+    if (sql.isEmpty()) return 0;
     QSqlQuery q(db);
-    q.exec(R"(SELECT a.title, a.category, a.start_time, a.end_time, a.capacity,
-              (SELECT COUNT(*) FROM enrollments e WHERE e.activity_id=a.id AND e.status='active') AS enrolled
-              FROM activities a ORDER BY a.start_time)");
-    QVector<QStringList> rows;
-    rows << QStringList{ "标题", "类别", "开始", "结束", "容量", "已报名" };
-    while (q.next()) {
-        rows << QStringList{
-            q.value(0).toString(),
-            q.value(1).toString(),
-            q.value(2).toString(),
-            q.value(3).toString(),
-            q.value(4).toString(),
-            q.value(5).toString()
-        };
+    return q.exec(sql) && q.next() ? q.value(0).toLongLong() : 0;
+}
+
+void ReportWorker::generateReport()
+{
+    QElapsedTimer timer;
+    timer.start();
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)
+            + QDir::separator() + QString("activity_report_%1").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmm"));
+    QDir().mkpath(dir);
+
+    const QVector<QueryJob> jobs {
+        { "activity_summary", tr("活动汇总"),
+          { "标题", "类别", "开始", "结束", "容量", "已报名", "候补" },
+          R"(SELECT a.title, a.category, a.start_time, a.end_time, a.capacity, a.enrolled_count, a.waiting_count
+             FROM activities a ORDER BY a.start_ts)",
+          "SELECT COUNT(*) FROM activities" },
+        { "category_stats", tr("分类统计"),
+          { "类别", "活动数", "总容量", "已报名", "候补" },
+          R"(SELECT category, COUNT(*), SUM(capacity), SUM(enrolled_count), SUM(waiting_count)
+             FROM activities GROUP BY category ORDER BY category)",
+          "SELECT COUNT(DISTINCT category) FROM activities" },
+        { "student_participation", tr("学生参与"),
+          { "学生", "已报名", "候补", "已取消" },
+          R"(SELECT student, SUM(status='active'), SUM(status='waiting'), SUM(status='cancelled')
+             FROM enrollments GROUP BY student ORDER BY student)",
+          "SELECT COUNT(DISTINCT student) FROM enrollments" },
+        { "waitlist_depth", tr("候补深度"),
+          { "标题", "开始", "容量", "已报名", "候补人数" },
+          R"(SELECT title, start_time, capacity, enrolled_count, waiting_count
+             FROM activities WHERE waiting_count > 0 ORDER BY waiting_count DESC)",
+          "SELECT COUNT(*) FROM activities WHERE waiting_count > 0" }
+    };
+
+    QMutex resultsMutex;
+    QVector<ReportJobResult> results;
+    auto collect = [&](const ReportJobResult &r) {
+        {
+            QMutexLocker locker(&resultsMutex);
+            results << r;
+        }
+        emit jobFinished(r);
+    };
+    for (const QueryJob &job : jobs) {
+        m_pool.start([this, job, dir, &collect]() {
+            emit jobStarted(job.name, job.title);
+            collect(runQueryJob(job, dir));
+        });
     }
-    const QString path = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)
-            + QDir::separator() + QString("activity_report_%1.csv").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmm"));
-    QString err;
-    if (CsvExporter::write(path, rows, &err)) {
-        emit finished(path);
-    } else {
-        emit finished(QStringLiteral("导出失败: %1").arg(err));
+    m_pool.start([this, dir, &collect]() {
+        emit jobStarted("conflicts", tr("冲突清单"));
+        collect(runConflictJob(dir));
+    });
+    m_pool.waitForDone();
+
+    // 被 cancel() 丢弃、从未开始的作业也要出现在结果里
+    if (cancelled()) {
+        QVector<QPair<QString, QString>> planned;
+        for (const QueryJob &job : jobs) planned << qMakePair(job.name, job.title);
+        planned << qMakePair(QStringLiteral("conflicts"), tr("冲突清单"));
+        for (const auto &job : std::as_const(planned)) {
+            const bool ran = std::any_of(results.cbegin(), results.cend(),
+                                         [&job](const ReportJobResult &r) { return r.name == job.first; });
+            if (ran) continue;
+            ReportJobResult r;
+            r.name = job.first;
+            r.title = job.second;
+            r.cancelled = true;
+            r.error = tr("已取消");
+            results << r;
+        }
     }
+
+    emit finished(dir, results, timer.elapsed());
 }
 
-void ReportWorker::checkConflicts()
+ReportJobResult ReportWorker::runQueryJob(const QueryJob &job, const QString &dir)
 {
-    QSqlDatabase db = openDb();
-    if (!db.isOpen()) return;
-    QSqlQuery q(db);
-    q.exec(R"(SELECT e.student, a.title, a.start_time, a.end_time
-              FROM enrollments e
-              JOIN activities a ON e.activity_id=a.id
-              WHERE e.status='active' AND a.status!='cancelled'
-              ORDER BY e.student, a.start_time)");
-    struct Item { QString title; QDateTime start; QDateTime end; };
-    QString lastStudent;
-    QList<Item> items;
-    QStringList conflictLines;
-    while (q.next()) {
-        const QString student = q.value(0).toString();
-        const QString title = q.value(1).toString();
-        const QDateTime start = QDateTime::fromString(q.value(2).toString(), Qt::ISODate);
-        const QDateTime end = QDateTime::fromString(q.value(3).toString(), Qt::ISODate);
-        if (student != lastStudent) {
-            items.clear();
-            lastStudent = student;
+    QElapsedTimer timer;
+    timer.start();
+    ReportJobResult r;
+    r.name = job.name;
+    r.title = job.title;
+    r.path = QDir(dir).filePath(job.name + ".csv");
+
+    ConnectionLease lease;
+    if (!lease.isValid()) {
+        r.error = lease.errorText();
+        return r;
+    }
+    if (cancelled()) {
+        r.cancelled = true;
+        r.error = tr("已取消");
+        return r;
+    }
+    ProgressThrottle progress(countRows(lease.database(), job.countSql));
+    CsvWriter writer;
+    if (!writer.open(r.path, &r.error)) return r;
+    {
+        // 游标边读边写，不在内存中保留整个结果集；每批行检查一次取消
+        QSqlQuery q(lease.database());
+        q.setForwardOnly(true);
+        if (!q.exec(job.sql)) {
+            r.error = q.lastError().text();
+            writer.close();
+            QFile::remove(r.path);
+            return r;
+        }
+        writer.writeRow(job.header);
+        r.rows = writer.writeQuery(q, [&](qint64 rows) {
+            if (cancelled()) return false;
+            if (progress.due()) emit jobProgress(job.name, rows, progress.total(), progress.etaMs(rows));
+            return true;
+        }, 256);
+    }
+    r.ok = writer.close(&r.error);
+    r.elapsedMs = timer.elapsed();
+    if (cancelled()) {
+        // 不保留半成品文件
+        QFile::remove(r.path);
+        r.ok = false;
+        r.cancelled = true;
+        r.error = tr("已取消");
+        return r;
+    }
+    emit jobProgress(job.name, r.rows, r.rows, 0);
+    return r;
+}
+
+ReportJobResult ReportWorker::runConflictJob(const QString &dir)
+{
+    QElapsedTimer timer;
+    timer.start();
+    ReportJobResult r;
+    r.name = "conflicts";
+    r.title = tr("冲突清单");
+    r.path = QDir(dir).filePath("conflicts.csv");
+
+    QVector<EnrollmentSpan> spans;
+    {
+        ConnectionLease lease;
+        if (!lease.isValid()) {
+            r.error = lease.errorText();
+            return r;
+        }
+        ProgressThrottle progress(countRows(lease.database(), "SELECT COUNT(*) FROM enrollments WHERE status='active'"));
+        QSqlQuery q(lease.database());
+        q.setForwardOnly(true);
+        if (!q.exec(R"(SELECT e.student, e.id, a.id, a.title, a.start_ts, a.end_ts
+                       FROM enrollments e
+                       JOIN activities a ON e.activity_id=a.id
+                       WHERE e.status='active' AND a.status!='cancelled')")) {
+            r.error = q.lastError().text();
+            return r;
         }
-        for (const auto &it : items) {
-            if (!(end <= it.start || start >= it.end)) {
-                conflictLines << QString("%1: 「%2」(%3-%4) 与 「%5」(%6-%7) 时间冲突")
-                                     .arg(student,
-                                          it.title,
-                                          it.start.toString("MM-dd hh:mm"), it.end.toString("MM-dd hh:mm"),
-                                          title,
-                                          start.toString("MM-dd hh:mm"), end.toString("MM-dd hh:mm"));
+        // 进度按读入的报名行计算，检测本身是 O(n log n) 的内存计算
+        while (q.next()) {
+            spans << EnrollmentSpan{ q.value(0).toString(), q.value(1).toInt(), q.value(2).toInt(),
+                                     q.value(3).toString(), q.value(4).toLongLong(), q.value(5).toLongLong() };
+            if (spans.size() % 256 == 0) {
+                if (cancelled()) break;
+                if (progress.due()) emit jobProgress(r.name, spans.size(), progress.total(), progress.etaMs(spans.size()));
             }
         }
-        items.append(Item{title, start, end});
     }
-    if (conflictLines.isEmpty()) {
-        emit conflictChecked(QStringLiteral("未发现时间冲突"));
-    } else {
-        emit conflictChecked(conflictLines.join('\n'));
+    if (cancelled()) {
+        r.cancelled = true;
+        r.error = tr("已取消");
+        r.elapsedMs = timer.elapsed();
+        return r;
     }
-}
 
+    const qint64 loaded = spans.size();
+    CsvWriter writer;
+    if (!writer.open(r.path, &r.error)) return r;
+    writer.writeRow({ "学生", "活动A", "A开始", "A结束", "活动B", "B开始", "B结束" });
+    // 分片回调来自线程池线程，写文件需串行；信号以排队方式送达界面
+    QMutex writerMutex;
+    const QString fmt = QStringLiteral("yyyy-MM-dd hh:mm");
+    const int total = ConflictDetector::detectSharded(std::move(spans), [&](const QVector<ConflictRecord> &records) {
+        // 检测本身无法中途停止，取消后剩余分片的结果直接丢弃
+        if (cancelled()) return;
+        {
+            QMutexLocker locker(&writerMutex);
+            for (const ConflictRecord &c : records) {
+                writer.writeRow({ c.student,
+                                  c.firstTitle, DbManager::formatEpoch(c.firstStart, fmt), DbManager::formatEpoch(c.firstEnd, fmt),
+                                  c.secondTitle, DbManager::formatEpoch(c.secondStart, fmt), DbManager::formatEpoch(c.secondEnd, fmt) });
+            }
+        }
+        emit conflictsFound(records);
+    });
+    r.ok = writer.close(&r.error);
+    r.elapsedMs = timer.elapsed();
+    if (cancelled()) {
+        // 与查询作业一致，不保留半成品文件
+        QFile::remove(r.path);
+        r.ok = false;
+        r.cancelled = true;
+        r.error = tr("已取消");
+        return r;
+    }
+    emit conflictCheckFinished(total);
+    r.rows = total;
+    emit jobProgress(r.name, loaded, loaded, 0);
+    return r;
+}
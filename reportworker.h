@@ -1,26 +1,75 @@
 #pragma once
 
+#include <QAtomicInt>
+#include <QMetaType>
 #include <QObject>
 #include <QSqlDatabase>
+#include <QThreadPool>
+#include <QVector>
+#include "utils/conflictdetector.h"
 
+struct ReportJobResult {
+    QString name;          // 作业标识，如 activity_summary
+    QString title;         // 显示名称
+    QString path;          // 输出文件
+    qint64 rows { 0 };
+    qint64 elapsedMs { 0 };
+    bool ok { false };
+    bool cancelled { false };
+    QString error;
+};
+Q_DECLARE_METATYPE(ReportJobResult)
+Q_DECLARE_METATYPE(QVector<ReportJobResult>)
+
+// 报表流水线：各报表作业互不依赖，在独立线程池中并发执行，
+// 每个作业在自己的线程上借用只读连接（WAL 下不阻塞报名写入），完成一个发出一次 jobFinished。
+// 作业按行检查取消标志，进度信号每个作业最多每 200ms 发出一次，并附带按当前速率估算的剩余时间。
 class ReportWorker : public QObject
 {
     Q_OBJECT
 public:
     explicit ReportWorker(QObject *parent = nullptr);
-    void setDatabase(const QSqlDatabase &db);
+    ~ReportWorker();
 
 public slots:
+    // 在工作线程中调用，阻塞至全部作业完成；界面经 startReport() 排队调用
     void generateReport();
-    void checkConflicts();
+
+public:
+    // 从调用方线程启动一次报表：先清除取消标志再排队执行 generateReport，
+    // 排队期间发出的 cancel() 因此不会被覆盖
+    void startReport();
+    // 请求取消当前报表：未开始的作业直接丢弃，进行中的作业在下一批行后停止并删除半成品文件。
+    // 工作线程此时阻塞在 generateReport 中，因此需从调用方线程直接调用（线程安全）
+    void cancel();
+    // 阻塞至线程池中已开始的作业全部结束（线程安全），关闭窗口前在 cancel() 之后调用
+    void waitForJobs();
 
 signals:
-    void finished(const QString &path);
-    void conflictChecked(const QString &message);
+    void jobStarted(const QString &name, const QString &title);
+    // total 为预估总行数（未知时为 0），etaMs 为估算剩余时间（未知时为 -1）
+    void jobProgress(const QString &name, qint64 done, qint64 total, qint64 etaMs);
+    void jobFinished(const ReportJobResult &result);
+    void finished(const QString &dir, const QVector<ReportJobResult> &results, qint64 elapsedMs);
+    // 冲突清单作业按分片批量送出冲突，全部完成后再发出 conflictCheckFinished
+    void conflictsFound(const QVector<ConflictRecord> &records);
+    void conflictCheckFinished(int total);
 
 private:
-    QString m_dbPath;
-    QString m_connName;
-    QSqlDatabase openDb();
-};
+    struct QueryJob {
+        QString name;
+        QString title;
+        QStringList header;
+        QString sql;
+        QString countSql; // 用于进度与剩余时间估算
+    };
+
+    bool cancelled() const { return m_cancel.loadRelaxed() != 0; }
+    qint64 countRows(const QSqlDatabase &db, const QString &sql) const;
 
+    ReportJobResult runQueryJob(const QueryJob &job, const QString &dir);
+    ReportJobResult runConflictJob(const QString &dir);
+
+    QThreadPool m_pool;
+    QAtomicInt m_cancel;
+};
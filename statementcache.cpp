@@ -0,0 +1,117 @@
+#include "statementcache.h"
+
+#include <QVariant>
+#include <utility>
+
+StatementLease::StatementLease(QSqlQuery *query, StatementCache *cache, const QString &sql)
+    : m_query(query)
+    , m_cache(cache)
+    , m_sql(sql)
+{
+}
+
+StatementLease::StatementLease(StatementLease &&other) noexcept
+    : m_query(other.m_query)
+    , m_cache(other.m_cache)
+    , m_sql(std::move(other.m_sql))
+{
+    other.m_query = nullptr;
+    other.m_cache = nullptr;
+}
+
+StatementLease::~StatementLease()
+{
+    if (!m_query) return;
+    if (m_cache) {
+        m_cache->release(m_sql, m_query);
+    } else {
+        m_query->finish();
+    }
+}
+
+StatementCache::StatementCache(const QSqlDatabase &db, int capacity)
+    : m_db(db)
+    , m_capacity(qMax(1, capacity))
+{
+}
+
+StatementCache::~StatementCache()
+{
+    clear();
+}
+
+StatementLease StatementCache::prepared(const QString &sql)
+{
+    auto it = m_queries.find(sql);
+    if (it != m_queries.end()) {
+        it->lastUsed = ++m_tick;
+        QSqlQuery *q = it->query;
+        m_hits.fetchAndAddRelaxed(1);
+        // 结束上次的结果集并清空绑定，避免残留参数带入本次执行
+        q->finish();
+        if (it->stale) {
+            // addBindValue 的位置计数只在 exec() 时归零；上次加了参数却没执行成功时重新 prepare 归零
+            if (!q->prepare(sql)) {
+                m_failed = *q;
+                if (it->leases == 0) {
+                    delete q;
+                    m_queries.erase(it);
+                }
+                return StatementLease(&m_failed);
+            }
+            it->stale = false;
+        } else {
+            const int bound = q->boundValues().size();
+            for (int i = 0; i < bound; ++i) {
+                q->bindValue(i, QVariant());
+            }
+        }
+        ++it->leases;
+        return StatementLease(q, this, sql);
+    }
+    m_misses.fetchAndAddRelaxed(1);
+    auto *q = new QSqlQuery(m_db);
+    if (!q->prepare(sql)) {
+        // 不缓存失败的语句（如迁移前表尚不存在），下次重新 prepare
+        m_failed = *q;
+        delete q;
+        return StatementLease(&m_failed);
+    }
+    if (m_queries.size() >= m_capacity) evictOldest();
+    m_queries.insert(sql, Entry{ q, ++m_tick, 1, false });
+    return StatementLease(q, this, sql);
+}
+
+void StatementCache::release(const QString &sql, QSqlQuery *query)
+{
+    auto it = m_queries.find(sql);
+    if (it == m_queries.end() || it->query != query) {
+        // 借出期间被 clear() 的语句已销毁
+        return;
+    }
+    if (--it->leases == 0 && !query->isActive()) it->stale = true;
+    query->finish();
+}
+
+void StatementCache::evictOldest()
+{
+    // 容量只有几十条，线性查找即可；仅在未命中时发生。借出中的语句不淘汰，全部借出时暂时超出上限
+    auto victim = m_queries.end();
+    for (auto it = m_queries.begin(); it != m_queries.end(); ++it) {
+        if (it->leases > 0) continue;
+        if (victim == m_queries.end() || it->lastUsed < victim->lastUsed) victim = it;
+    }
+    if (victim == m_queries.end()) return;
+    delete victim->query;
+    m_queries.erase(victim);
+    m_evictions.fetchAndAddRelaxed(1);
+}
+
+void StatementCache::clear()
+{
+    for (const Entry &e : std::as_const(m_queries)) {
+        delete e.query;
+    }
+    m_queries.clear();
+    m_failed = QSqlQuery();
+}
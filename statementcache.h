@@ -0,0 +1,70 @@
+#pragma once
+
+#include <QAtomicInteger>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+
+class StatementCache;
+
+// 借出的预编译语句（RAII）：析构时 finish()，结束结果集。
+// 只读了一行就停下的 SELECT 若不 finish，会在池化连接上一直持有读事务，
+// 钉住 WAL 快照、阻止 checkpoint，并让同一连接上随后的 BEGIN IMMEDIATE 报 SQLITE_BUSY_SNAPSHOT。
+class StatementLease
+{
+public:
+    explicit StatementLease(QSqlQuery *query, StatementCache *cache = nullptr, const QString &sql = QString());
+    StatementLease(StatementLease &&other) noexcept;
+    ~StatementLease();
+
+    QSqlQuery &query() const { return *m_query; }
+
+private:
+    Q_DISABLE_COPY(StatementLease)
+    QSqlQuery *m_query;
+    StatementCache *m_cache;
+    QString m_sql;
+};
+
+// 按 SQL 文本缓存已 prepare 的语句，挂在连接池的每个连接上（与连接同线程使用）。
+// 取出的语句已 finish() 且位置参数清空；调用方按 addBindValue + exec() 的顺序使用，
+// 同一条 SQL 不要嵌套取用。
+// 条目数超过 capacity 时淘汰最久未用且未借出的语句（如参数个数不同的 IN (?,?…) 列表各占一条）。
+class StatementCache
+{
+public:
+    explicit StatementCache(const QSqlDatabase &db, int capacity = 64);
+    ~StatementCache();
+
+    // prepare 失败时返回的语句 isValid() 为 false，lastError() 中有原因
+    StatementLease prepared(const QString &sql);
+    void clear();
+
+    quint64 hits() const { return m_hits.loadRelaxed(); }
+    quint64 misses() const { return m_misses.loadRelaxed(); }
+    quint64 evictions() const { return m_evictions.loadRelaxed(); }
+    int size() const { return m_queries.size(); }
+
+private:
+    Q_DISABLE_COPY(StatementCache)
+    friend class StatementLease;
+    struct Entry {
+        QSqlQuery *query { nullptr };
+        quint64 lastUsed { 0 };
+        int leases { 0 };
+        bool stale { false }; // 上次借出后未成功 exec，位置参数计数可能残留
+    };
+
+    void release(const QString &sql, QSqlQuery *query);
+    void evictOldest();
+
+    QSqlDatabase m_db;
+    int m_capacity;
+    quint64 m_tick { 0 };
+    QHash<QString, Entry> m_queries;
+    QSqlQuery m_failed;
+    QAtomicInteger<quint64> m_hits { 0 };
+    QAtomicInteger<quint64> m_misses { 0 };
+    QAtomicInteger<quint64> m_evictions { 0 };
+};
@@ -0,0 +1,149 @@
+// CSV 导出吞吐基准：对比旧版 CsvExporter（逐格复制 + QStringList join + QTextStream 编码）
+// 与 CsvWriter（单次扫描、直接编码到复用缓冲区）。
+// 构建命令见 README「性能基准」；用法：csvbench [行数]
+#include "utils/csvwriter.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QVector>
+#include <cstdio>
+
+namespace {
+QVector<QStringList> makeRows(int count)
+{
+    // 与实际导出相近：中文标题、学号、状态、序号，少量字段含逗号/引号
+    QVector<QStringList> rows;
+    rows.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QString title = QStringLiteral("校园活动%1：志愿者招募").arg(i % 997);
+        if (i % 17 == 0) title += QStringLiteral(", 第二场");
+        if (i % 31 == 0) title += QStringLiteral(" \"特别场\"");
+        rows << QStringList{ title,
+                             QStringLiteral("student%1").arg(i % 50000, 5, 10, QChar('0')),
+                             i % 5 == 0 ? QStringLiteral("waiting") : QStringLiteral("active"),
+                             QString::number(i % 5 == 0 ? i % 40 : 0) };
+    }
+    return rows;
+}
+
+// 原 CsvExporter 的行转义：逐格复制、按需加引号，再 join；两项对照测量共用这一份实现
+QString legacyEscapeRow(const QStringList &row)
+{
+    QStringList escaped;
+    for (const QString &cell : row) {
+        QString val = cell;
+        if (val.contains('"') || val.contains(',')) {
+            val.replace("\"", "\"\"");
+            val = "\"" + val + "\"";
+        }
+        escaped << val;
+    }
+    return escaped.join(',');
+}
+
+// 原 CsvExporter::write 的实现，作为对照
+bool legacyWrite(const QString &path, const QVector<QStringList> &rows)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return false;
+    QTextStream out(&file);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    out.setEncoding(QStringConverter::Utf8);
+#else
+    out.setCodec("UTF-8");
+#endif
+    out.setGenerateByteOrderMark(true);
+    for (const auto &row : rows) {
+        out << legacyEscapeRow(row) << '\n';
+    }
+    out.flush();
+    return !out.status();
+}
+
+bool writerWrite(const QString &path, const QVector<QStringList> &rows)
+{
+    CsvWriter writer;
+    if (!writer.open(path)) return false;
+    for (const auto &row : rows) {
+        writer.writeRow(row);
+    }
+    return writer.close();
+}
+
+void report(const char *name, qint64 bytes, qint64 nsecs)
+{
+    const double seconds = nsecs / 1e9;
+    std::printf("%-28s %10.1f ms %10.1f MB/s\n", name, nsecs / 1e6, bytes / 1048576.0 / seconds);
+}
+
+template <typename Fn>
+qint64 bestOf(int rounds, Fn fn)
+{
+    qint64 best = -1;
+    for (int i = 0; i < rounds; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        fn();
+        const qint64 elapsed = timer.nsecsElapsed();
+        if (best < 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const int count = argc > 1 ? qMax(1, QString(argv[1]).toInt()) : 200000;
+    const int rounds = 5;
+    const QVector<QStringList> rows = makeRows(count);
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::fprintf(stderr, "cannot create temp dir\n");
+        return 1;
+    }
+    const QString legacyPath = dir.filePath("legacy.csv");
+    const QString writerPath = dir.filePath("writer.csv");
+
+    std::printf("rows: %d, best of %d\n", count, rounds);
+
+    // 纯编码：不含文件 I/O
+    QByteArray sink;
+    const qint64 encodeLegacy = bestOf(rounds, [&]() {
+        sink.clear();
+        for (const auto &row : rows) {
+            sink += legacyEscapeRow(row).toUtf8();
+            sink += '\n';
+        }
+    });
+    const qint64 encodedBytes = sink.size();
+    report("encode: legacy", encodedBytes, encodeLegacy);
+
+    const qint64 encodeWriter = bestOf(rounds, [&]() {
+        sink.resize(0);
+        for (const auto &row : rows) {
+            for (int i = 0; i < row.size(); ++i) {
+                if (i > 0) sink += ',';
+                CsvWriter::appendField(sink, row.at(i));
+            }
+            sink += '\n';
+        }
+    });
+    report("encode: CsvWriter", sink.size(), encodeWriter);
+
+    // 端到端写文件
+    const qint64 fileLegacy = bestOf(rounds, [&]() { legacyWrite(legacyPath, rows); });
+    report("file: legacy CsvExporter", QFileInfo(legacyPath).size(), fileLegacy);
+    const qint64 fileWriter = bestOf(rounds, [&]() { writerWrite(writerPath, rows); });
+    report("file: CsvWriter", QFileInfo(writerPath).size(), fileWriter);
+
+    std::printf("speedup: encode %.2fx, file %.2fx\n",
+                double(encodeLegacy) / encodeWriter, double(fileLegacy) / fileWriter);
+    return 0;
+}
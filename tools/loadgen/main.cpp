@@ -0,0 +1,320 @@
+// 报名高峰压测：无界面，直接驱动与数据服务相同的 EnrollmentEngine（报名/候补/取消的同一套 SQL 与事务），
+// 多线程同时开抢同一批活动，输出吞吐、p50/p99 延迟、SQLITE_BUSY 比例以及结束后的容量/计数不变量检查。
+// 构建命令见 README「性能基准」；用法见 loadgen --help。不变量被破坏时以非零状态退出。
+#include "connectionpool.h"
+#include "dbmanager.h"
+#include "enrollmentengine.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QPair>
+#include <QRandomGenerator>
+#include <QSemaphore>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+enum Op { OpEnroll, OpWaitlist, OpCancel, OpCount };
+const char *const kOpNames[OpCount] = { "enroll", "waitlist", "cancel" };
+
+struct Options {
+    QString dbPath;
+    int activities { 10 };
+    int students { 2000 };
+    int capacity { 50 };
+    int threads { 8 };
+    int opsPerThread { 500 };
+    double hotShare { 0.8 };  // 落在 1 号热门活动上的比例
+    int mix[OpCount] { 70, 10, 20 }; // enroll/waitlist/cancel 权重
+    quint32 seed { 1 };
+};
+
+struct OpStats {
+    QVector<qint64> latencyNs;
+    qint64 ok { 0 };
+    qint64 rejected { 0 }; // 重复、冲突、无名额等业务拒绝
+    qint64 failed { 0 };
+    qint64 busy { 0 };     // 失败中属于 SQLITE_BUSY/LOCKED 的
+};
+
+struct ThreadResult {
+    OpStats ops[OpCount];
+    QString error;
+};
+
+bool isBusy(const QString &error)
+{
+    return error.contains("locked", Qt::CaseInsensitive) || error.contains("busy", Qt::CaseInsensitive);
+}
+
+qint64 percentile(const QVector<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty()) return 0;
+    const int last = int(sorted.size()) - 1;
+    const int idx = qBound(0, int(p * last + 0.5), last);
+    return sorted.at(idx);
+}
+
+QList<int> seedActivities(DbManager &db, const Options &opt)
+{
+    QList<int> ids;
+    QSqlQuery act(db.database());
+    act.prepare(R"(INSERT INTO activities(title, category, location, start_time, end_time, capacity, status, creator, approver)
+                   VALUES(?,?,?,?,?,?,'approved','loadgen','admin'))");
+    // 每个活动相隔一天，学生同时报多个活动不会因时间冲突被拒
+    const QDateTime base = QDateTime::currentDateTime().addDays(30);
+    for (int i = 0; i < opt.activities; ++i) {
+        const QDateTime start = base.addDays(i);
+        act.addBindValue(QString("压测活动%1").arg(i + 1));
+        act.addBindValue("压测");
+        act.addBindValue("礼堂");
+        act.addBindValue(start.toString(Qt::ISODate));
+        act.addBindValue(start.addSecs(7200).toString(Qt::ISODate));
+        act.addBindValue(opt.capacity);
+        if (!act.exec()) {
+            std::fprintf(stderr, "seed activity failed: %s\n", qPrintable(act.lastError().text()));
+            return QList<int>();
+        }
+        ids << act.lastInsertId().toInt();
+    }
+    return ids;
+}
+
+bool seedStudents(DbManager &db, const Options &opt)
+{
+    QSqlQuery exists(db.database());
+    exists.prepare("SELECT 1 FROM users WHERE username=?");
+    for (int i = 0; i < opt.students; ++i) {
+        const QString name = QString("load_stu%1").arg(i, 5, 10, QChar('0'));
+        exists.addBindValue(name);
+        const bool found = exists.exec() && exists.next();
+        exists.finish();
+        if (found) continue;
+        QString err;
+        if (!db.createUser(name, "123456", "student", &err)) {
+            std::fprintf(stderr, "seed student failed: %s\n", qPrintable(err));
+            return false;
+        }
+    }
+    return true;
+}
+
+void runWorker(const Options &opt, int index, const QList<int> &activities, QSemaphore *start, ThreadResult *out)
+{
+    QRandomGenerator rng(opt.seed * 7919u + quint32(index));
+    const int mixTotal = opt.mix[OpEnroll] + opt.mix[OpWaitlist] + opt.mix[OpCancel];
+    QVector<QPair<int, QString>> mine; // 本线程创建、尚未取消的报名记录及其学生
+
+    ConnectionLease lease;
+    if (!lease.isValid()) {
+        out->error = lease.errorText();
+        start->acquire();
+        return;
+    }
+    EnrollmentEngine engine(lease.database());
+    for (auto &s : out->ops) s.latencyNs.reserve(opt.opsPerThread);
+
+    start->acquire(); // 所有线程就绪后同时开抢
+    for (int i = 0; i < opt.opsPerThread; ++i) {
+        const int roll = rng.bounded(mixTotal);
+        Op op = roll < opt.mix[OpEnroll] ? OpEnroll
+              : roll < opt.mix[OpEnroll] + opt.mix[OpWaitlist] ? OpWaitlist : OpCancel;
+        if (op == OpCancel && mine.isEmpty()) op = OpEnroll;
+
+        const int activity = rng.generateDouble() < opt.hotShare || activities.size() == 1
+                ? activities.first()
+                : activities.at(1 + rng.bounded(int(activities.size()) - 1));
+        const QString student = QString("load_stu%1").arg(rng.bounded(opt.students), 5, 10, QChar('0'));
+
+        OpStats &stats = out->ops[op];
+        QElapsedTimer timer;
+        timer.start();
+        QString error;
+        bool ok = false;
+        bool rejected = false;
+        if (op == OpCancel) {
+            const int pick = rng.bounded(int(mine.size()));
+            const CancelResult r = engine.cancel(mine.at(pick).first, mine.at(pick).second);
+            ok = r.ok;
+            error = r.error;
+            if (ok) mine.remove(pick);
+        } else {
+            const EnrollResult r = engine.enroll(activity, student,
+                                                 op == OpEnroll ? EnrollmentEngine::Auto : EnrollmentEngine::WaitlistOnly);
+            ok = r.outcome == EnrollResult::Enrolled || r.outcome == EnrollResult::Waitlisted;
+            rejected = r.outcome == EnrollResult::Duplicate || r.outcome == EnrollResult::Conflict
+                    || r.outcome == EnrollResult::NotAvailable;
+            error = r.error;
+            if (ok) mine << qMakePair(r.enrollmentId, student);
+        }
+        stats.latencyNs << timer.nsecsElapsed();
+        if (ok) {
+            ++stats.ok;
+        } else if (rejected) {
+            ++stats.rejected;
+        } else {
+            ++stats.failed;
+            if (isBusy(error)) ++stats.busy;
+        }
+    }
+}
+
+int scalar(DbManager &db, const QString &sql)
+{
+    QSqlQuery q(db.database());
+    if (!q.exec(sql) || !q.next()) {
+        std::fprintf(stderr, "check failed: %s\n", qPrintable(q.lastError().text()));
+        return -1;
+    }
+    return q.value(0).toInt();
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("CampusActivity");
+    QCoreApplication::setApplicationName("ActivityManager");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Registration rush load generator");
+    parser.addHelpOption();
+    parser.addOptions({
+        { "db", "SQLite file (default: fresh temporary database)", "path" },
+        { "activities", "Activities to seed (default 10)", "n" },
+        { "students", "Students to seed (default 2000)", "n" },
+        { "capacity", "Capacity per activity (default 50)", "n" },
+        { "threads", "Concurrent workers (default 8)", "n" },
+        { "ops", "Operations per worker (default 500)", "n" },
+        { "hot", "Share of operations on the first activity, 0-1 (default 0.8)", "ratio" },
+        { "mix", "enroll:waitlist:cancel weights (default 70:10:20)", "weights" },
+        { "seed", "Random seed (default 1)", "n" },
+    });
+    parser.process(app);
+
+    Options opt;
+    auto intOption = [&](const char *name, int fallback, int minimum) {
+        return parser.isSet(name) ? qMax(minimum, parser.value(name).toInt()) : fallback;
+    };
+    opt.activities = intOption("activities", opt.activities, 1);
+    opt.students = intOption("students", opt.students, 1);
+    opt.capacity = intOption("capacity", opt.capacity, 1);
+    opt.threads = intOption("threads", opt.threads, 1);
+    opt.opsPerThread = intOption("ops", opt.opsPerThread, 1);
+    opt.seed = quint32(intOption("seed", int(opt.seed), 0));
+    if (parser.isSet("hot")) opt.hotShare = qBound(0.0, parser.value("hot").toDouble(), 1.0);
+    if (parser.isSet("mix")) {
+        const QStringList parts = parser.value("mix").split(':');
+        if (parts.size() != OpCount) {
+            std::fprintf(stderr, "--mix expects three weights, e.g. 70:10:20\n");
+            return 2;
+        }
+        for (int i = 0; i < OpCount; ++i) opt.mix[i] = qMax(0, parts.at(i).toInt());
+        if (opt.mix[OpEnroll] + opt.mix[OpWaitlist] + opt.mix[OpCancel] == 0) opt.mix[OpEnroll] = 1;
+    }
+
+    QTemporaryDir tempDir;
+    opt.dbPath = parser.isSet("db") ? parser.value("db") : tempDir.filePath("loadgen.db");
+    DbManager db;
+    if (!db.open(opt.dbPath) || !db.initSchema()) {
+        std::fprintf(stderr, "cannot open %s: %s\n", qPrintable(opt.dbPath), qPrintable(db.lastErrorText()));
+        return 1;
+    }
+    // 每个工作线程一条连接，另留一条给本线程
+    ConnectionPool::instance().setMaxConnections(opt.threads + 1);
+
+    QElapsedTimer seedTimer;
+    seedTimer.start();
+    db.database().transaction();
+    const QList<int> activities = seedActivities(db, opt);
+    const bool seeded = !activities.isEmpty() && seedStudents(db, opt);
+    if (!seeded || !db.database().commit()) {
+        db.database().rollback();
+        return 1;
+    }
+    std::printf("db: %s\nseeded %d activities (capacity %d), %d students in %lld ms\n",
+                qPrintable(opt.dbPath), opt.activities, opt.capacity, opt.students, seedTimer.elapsed());
+    std::printf("threads: %d x %d ops, hot share %.2f, mix %d:%d:%d\n", opt.threads, opt.opsPerThread, opt.hotShare,
+                opt.mix[OpEnroll], opt.mix[OpWaitlist], opt.mix[OpCancel]);
+
+    QSemaphore start;
+    QVector<ThreadResult> results(opt.threads);
+    std::vector<std::unique_ptr<QThread>> workers;
+    for (int i = 0; i < opt.threads; ++i) {
+        ThreadResult *out = &results[i];
+        workers.emplace_back(QThread::create([&opt, i, &activities, &start, out]() {
+            runWorker(opt, i, activities, &start, out);
+        }));
+        workers.back()->start();
+    }
+    // 给线程时间借出连接、准备语句，再同时放行
+    QThread::msleep(200);
+    QElapsedTimer wall;
+    wall.start();
+    start.release(opt.threads);
+    for (auto &worker : workers) worker->wait();
+    const qint64 wallMs = qMax<qint64>(1, wall.elapsed());
+
+    OpStats total;
+    for (const ThreadResult &r : std::as_const(results)) {
+        if (!r.error.isEmpty()) std::fprintf(stderr, "worker error: %s\n", qPrintable(r.error));
+    }
+    std::printf("\n%-10s %8s %8s %8s %8s %8s %10s %10s %10s\n",
+                "op", "count", "ok", "reject", "failed", "busy", "p50 ms", "p99 ms", "max ms");
+    for (int op = 0; op < OpCount; ++op) {
+        OpStats merged;
+        for (const ThreadResult &r : std::as_const(results)) {
+            const OpStats &s = r.ops[op];
+            merged.latencyNs += s.latencyNs;
+            merged.ok += s.ok;
+            merged.rejected += s.rejected;
+            merged.failed += s.failed;
+            merged.busy += s.busy;
+        }
+        std::sort(merged.latencyNs.begin(), merged.latencyNs.end());
+        std::printf("%-10s %8d %8lld %8lld %8lld %8lld %10.2f %10.2f %10.2f\n", kOpNames[op],
+                    int(merged.latencyNs.size()), merged.ok, merged.rejected, merged.failed, merged.busy,
+                    percentile(merged.latencyNs, 0.50) / 1e6, percentile(merged.latencyNs, 0.99) / 1e6,
+                    (merged.latencyNs.isEmpty() ? 0 : merged.latencyNs.last()) / 1e6);
+        total.latencyNs += merged.latencyNs;
+        total.ok += merged.ok;
+        total.rejected += merged.rejected;
+        total.failed += merged.failed;
+        total.busy += merged.busy;
+    }
+    std::sort(total.latencyNs.begin(), total.latencyNs.end());
+    const int count = int(total.latencyNs.size());
+    std::printf("%-10s %8d %8lld %8lld %8lld %8lld %10.2f %10.2f %10.2f\n", "all", count, total.ok,
+                total.rejected, total.failed, total.busy,
+                percentile(total.latencyNs, 0.50) / 1e6, percentile(total.latencyNs, 0.99) / 1e6,
+                (total.latencyNs.isEmpty() ? 0 : total.latencyNs.last()) / 1e6);
+    std::printf("\nthroughput: %.1f ops/s over %lld ms, busy rate %.2f%%\n",
+                count * 1000.0 / wallMs, wallMs, count ? total.busy * 100.0 / count : 0.0);
+
+    // 不变量：任何活动的有效报名不超过容量、计数列与报名表一致、同一学生对同一活动至多一条有效记录
+    const int overCapacity = scalar(db, R"(SELECT COUNT(*) FROM activities a
+                                          WHERE (SELECT COUNT(*) FROM enrollments e
+                                                 WHERE e.activity_id=a.id AND e.status='active') > a.capacity)");
+    const int duplicates = scalar(db, R"(SELECT COUNT(*) FROM (
+                                            SELECT 1 FROM enrollments WHERE status IN ('active','waiting')
+                                            GROUP BY activity_id, student HAVING COUNT(*) > 1))");
+    int counterMismatch = 0;
+    if (!db.verifyCounters(&counterMismatch)) counterMismatch = qMax(1, counterMismatch);
+    std::printf("invariants: over-capacity %d, duplicate enrollments %d, counter mismatches %d\n",
+                overCapacity, duplicates, counterMismatch);
+    const bool violated = overCapacity != 0 || duplicates != 0 || counterMismatch != 0;
+    std::printf("%s\n", violated ? "FAIL" : "OK");
+    return violated ? 3 : 0;
+}
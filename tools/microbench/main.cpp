@@ -0,0 +1,316 @@
+// 数据与导出热点路径的微基准：按 1k/100k/1M 行生成合成数据，分别测量
+//   csv.write              CsvExporter::write（内存行集写文件）
+//   conflicts.detect       ConflictDetector::detect（报表冲突清单的单线程检测）
+//   conflicts.sharded      ConflictDetector::detectSharded（报表实际使用的分片并行检测）
+//   activities.category    活动列表按分类筛选：构造分页查询 + 取首页与总数（筛选框变化时的完整路径）
+//   activities.keyword     同上，按关键字（FTS5 trigram 可用时走全文索引）
+//   available.load         学生端可报名活动整表加载
+//   stats.reload           统计快照全量重算（新实例，无缓存）
+//   stats.cached           统计快照命中缓存
+// 每项预热一次后至少运行 3 次、累计至少 300ms，取单次耗时中位数。
+// --json 输出机器可读结果；--baseline 与既有结果对比，超出 --tolerance（默认 15%）记为回归并以退出码 4 结束。
+// 构建命令见 README「性能基准」。
+#include "dataservice.h"
+#include "dbmanager.h"
+#include "utils/conflictdetector.h"
+#include "utils/csvexporter.h"
+
+#include <QAtomicInt>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+namespace {
+struct BenchResult {
+    QString name;
+    int rows { 0 };
+    qint64 nsPerIter { 0 };
+    int iterations { 0 };
+
+    QString key() const { return QString("%1@%2").arg(name).arg(rows); }
+};
+
+template <typename Fn>
+BenchResult measure(const QString &name, int rows, Fn fn)
+{
+    fn(); // 预热：语句缓存、页缓存
+    QVector<qint64> samples;
+    QElapsedTimer total;
+    total.start();
+    while (samples.size() < 3 || (total.elapsed() < 300 && samples.size() < 1000)) {
+        QElapsedTimer timer;
+        timer.start();
+        fn();
+        samples << timer.nsecsElapsed();
+    }
+    std::sort(samples.begin(), samples.end());
+    BenchResult r { name, rows, samples.at(samples.size() / 2), int(samples.size()) };
+    std::printf("%-22s %9d rows %12.3f ms  (%d runs)\n", qPrintable(name), rows, r.nsPerIter / 1e6, r.iterations);
+    std::fflush(stdout);
+    return r;
+}
+
+// 在本线程的事件循环中执行 DataService 请求，直到目标信号到达
+template <typename Signal, typename Call>
+void callAndWait(DataService *service, Signal signal, Call call)
+{
+    QEventLoop loop;
+    const QMetaObject::Connection c = QObject::connect(service, signal, &loop, [&loop]() { loop.quit(); });
+    call();
+    loop.exec();
+    QObject::disconnect(c);
+}
+
+bool execOrWarn(QSqlQuery &q)
+{
+    if (q.exec()) return true;
+    std::fprintf(stderr, "seed failed: %s\n", qPrintable(q.lastError().text()));
+    return false;
+}
+
+// 用递归 CTE 在库内批量生成数据，触发器照常维护计数列、epoch 列与全文索引
+bool seedDatabase(DbManager &db, int rows)
+{
+    QSqlDatabase conn = db.database();
+    conn.transaction();
+    QSqlQuery q(conn);
+    q.prepare(R"(WITH RECURSIVE seq(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM seq WHERE i < ?)
+                 INSERT INTO activities(title, category, location, start_time, end_time, capacity, status, creator, approver)
+                 SELECT '活动' || i || CASE i % 3 WHEN 0 THEN ' 志愿者招募' WHEN 1 THEN ' 学术讲座' ELSE ' 篮球友谊赛' END,
+                        CASE i % 4 WHEN 0 THEN '社团' WHEN 1 THEN '学术' WHEN 2 THEN '体育' ELSE '公益' END,
+                        '教室' || (i % 200),
+                        strftime('%Y-%m-%dT%H:%M:%S', '2026-01-01', '+' || (i * 37 % 525600) || ' minutes'),
+                        strftime('%Y-%m-%dT%H:%M:%S', '2026-01-01', '+' || (i * 37 % 525600 + 90) || ' minutes'),
+                        50,
+                        CASE WHEN i % 10 = 0 THEN 'pending' ELSE 'approved' END,
+                        'host' || (i % 50),
+                        CASE WHEN i % 10 = 0 THEN NULL ELSE 'admin' END
+                 FROM seq)");
+    q.addBindValue(rows);
+    if (!execOrWarn(q)) return false;
+    // 每名学生约 10 条报名，约八分之一为候补
+    q.prepare(R"(WITH RECURSIVE seq(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM seq WHERE i < ?)
+                 INSERT INTO enrollments(activity_id, student, created_at, status, position)
+                 SELECT 1 + (i * 7919) % ?, 'stu' || (i % ?), strftime('%Y-%m-%dT%H:%M:%S', 'now', 'localtime'),
+                        CASE WHEN i % 8 = 0 THEN 'waiting' ELSE 'active' END,
+                        CASE WHEN i % 8 = 0 THEN i ELSE 0 END
+                 FROM seq)");
+    q.addBindValue(rows);
+    q.addBindValue(rows);
+    q.addBindValue(qMax(1, rows / 10));
+    if (!execOrWarn(q)) return false;
+    return conn.commit();
+}
+
+QVector<QStringList> makeCsvRows(int count)
+{
+    QVector<QStringList> rows;
+    rows.reserve(count + 1);
+    rows << QStringList{ "标题", "学生", "开始", "结束", "状态", "候补序号" };
+    for (int i = 0; i < count; ++i) {
+        QString title = QStringLiteral("校园活动%1：志愿者招募").arg(i % 997);
+        if (i % 17 == 0) title += QStringLiteral(", 第二场");
+        rows << QStringList{ title, QStringLiteral("stu%1").arg(i % 50000), QStringLiteral("2026-03-01T09:00:00"),
+                             QStringLiteral("2026-03-01T11:00:00"), i % 8 == 0 ? "waiting" : "active",
+                             QString::number(i % 8 == 0 ? i : 0) };
+    }
+    return rows;
+}
+
+QVector<EnrollmentSpan> makeSpans(int count)
+{
+    QRandomGenerator rng(42);
+    QVector<EnrollmentSpan> spans;
+    spans.reserve(count);
+    const int students = qMax(1, count / 10);
+    const qint64 base = 1767225600; // 2026-01-01
+    for (int i = 0; i < count; ++i) {
+        const qint64 start = base + qint64(rng.bounded(365 * 24)) * 3600;
+        spans << EnrollmentSpan{ QStringLiteral("stu%1").arg(i % students), i + 1, i + 1,
+                                 QStringLiteral("活动%1").arg(i + 1), start, start + 3600 * (1 + rng.bounded(3)) };
+    }
+    return spans;
+}
+
+QVector<BenchResult> runSize(int rows, const QString &dir)
+{
+    QVector<BenchResult> results;
+
+    const QVector<QStringList> csvRows = makeCsvRows(rows);
+    const QString csvPath = QString("%1/bench_%2.csv").arg(dir).arg(rows);
+    results << measure("csv.write", rows, [&]() { CsvExporter::write(csvPath, csvRows); });
+    QFile::remove(csvPath);
+
+    const QVector<EnrollmentSpan> spans = makeSpans(rows);
+    results << measure("conflicts.detect", rows, [&]() { ConflictDetector::detect(spans); });
+    results << measure("conflicts.sharded", rows, [&]() {
+        QAtomicInt found;
+        ConflictDetector::detectSharded(spans, [&found](const QVector<ConflictRecord> &records) {
+            found.fetchAndAddRelaxed(records.size());
+        });
+    });
+
+    DbManager db;
+    const QString dbPath = QString("%1/bench_%2.db").arg(dir).arg(rows);
+    QElapsedTimer seedTimer;
+    seedTimer.start();
+    if (!db.open(dbPath) || !db.initSchema() || !seedDatabase(db, rows)) {
+        std::fprintf(stderr, "cannot prepare %s: %s\n", qPrintable(dbPath), qPrintable(db.lastErrorText()));
+        return results;
+    }
+    std::printf("%-22s %9d rows %12.3f ms\n", "(seed)", rows, seedTimer.nsecsElapsed() / 1e6);
+
+    {
+        DataService service;
+        auto firstPage = [&](const ActivityFilter &filter) {
+            PageQuery query;
+            QEventLoop loop;
+            const QMetaObject::Connection c = QObject::connect(&service, &DataService::activityQueryReady, &loop,
+                                                               [&](const PageQuery &q) {
+                                                                   query = q;
+                                                                   loop.quit();
+                                                               });
+            service.loadActivities(filter);
+            loop.exec();
+            QObject::disconnect(c);
+            PageRequest request;
+            request.pageSize = 200;
+            request.withTotal = true;
+            request.query = query;
+            callAndWait(&service, &DataService::pageLoaded, [&]() { service.fetchPage(request); });
+        };
+        ActivityFilter byCategory;
+        byCategory.role = "admin";
+        byCategory.category = "学术";
+        results << measure("activities.category", rows, [&]() { firstPage(byCategory); });
+        ActivityFilter byKeyword;
+        byKeyword.role = "admin";
+        byKeyword.keyword = "志愿者";
+        results << measure("activities.keyword", rows, [&]() { firstPage(byKeyword); });
+
+        results << measure("available.load", rows, [&]() {
+            callAndWait(&service, &DataService::availableActivitiesLoaded, [&]() { service.loadAvailableActivities(); });
+        });
+        results << measure("stats.cached", rows, [&]() {
+            callAndWait(&service, &DataService::statsLoaded, [&]() { service.loadStats(); });
+        });
+    }
+    results << measure("stats.reload", rows, [&]() {
+        DataService fresh;
+        callAndWait(&fresh, &DataService::statsLoaded, [&]() { fresh.loadStats(); });
+    });
+    db.close(true);
+    QFile::remove(dbPath);
+    return results;
+}
+
+QJsonObject toJson(const QVector<BenchResult> &results)
+{
+    QJsonArray items;
+    for (const BenchResult &r : results) {
+        items.append(QJsonObject{ { "name", r.name }, { "rows", r.rows },
+                                  { "ns_per_iter", double(r.nsPerIter) }, { "iterations", r.iterations } });
+    }
+    return QJsonObject{ { "version", 1 }, { "qt", QString(qVersion()) }, { "results", items } };
+}
+
+// 返回回归项数；基线缺失的条目只提示不计入
+int compareBaseline(const QVector<BenchResult> &results, const QString &path, double tolerance)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::fprintf(stderr, "cannot read baseline %s\n", qPrintable(path));
+        return -1;
+    }
+    QHash<QString, double> baseline;
+    const QJsonArray items = QJsonDocument::fromJson(file.readAll()).object().value("results").toArray();
+    for (const QJsonValue &v : items) {
+        const QJsonObject o = v.toObject();
+        baseline.insert(QString("%1@%2").arg(o.value("name").toString()).arg(o.value("rows").toInt()),
+                        o.value("ns_per_iter").toDouble());
+    }
+    int regressions = 0;
+    std::printf("\n%-32s %12s %12s %8s\n", "benchmark", "baseline ms", "current ms", "change");
+    for (const BenchResult &r : results) {
+        const auto it = baseline.constFind(r.key());
+        if (it == baseline.constEnd() || *it <= 0) {
+            std::printf("%-32s %12s %12.3f %8s\n", qPrintable(r.key()), "-", r.nsPerIter / 1e6, "new");
+            continue;
+        }
+        const double change = (r.nsPerIter - *it) / *it;
+        const bool regressed = change > tolerance;
+        if (regressed) ++regressions;
+        std::printf("%-32s %12.3f %12.3f %+7.1f%%%s\n", qPrintable(r.key()), *it / 1e6, r.nsPerIter / 1e6,
+                    change * 100, regressed ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("CampusActivity");
+    QCoreApplication::setApplicationName("ActivityManager");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Micro-benchmarks for data and export hot paths");
+    parser.addHelpOption();
+    parser.addOptions({
+        { "sizes", "Comma-separated dataset sizes (default 1000,100000,1000000)", "list" },
+        { "json", "Write results as JSON to this file", "path" },
+        { "baseline", "Compare against a previous --json result", "path" },
+        { "tolerance", "Allowed slowdown before flagging a regression (default 0.15)", "ratio" },
+    });
+    parser.process(app);
+
+    QList<int> sizes { 1000, 100000, 1000000 };
+    if (parser.isSet("sizes")) {
+        sizes.clear();
+        for (const QString &s : parser.value("sizes").split(',', Qt::SkipEmptyParts)) {
+            if (s.toInt() > 0) sizes << s.toInt();
+        }
+    }
+    const double tolerance = parser.isSet("tolerance") ? qMax(0.0, parser.value("tolerance").toDouble()) : 0.15;
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::fprintf(stderr, "cannot create temp dir\n");
+        return 1;
+    }
+    QVector<BenchResult> results;
+    for (int rows : std::as_const(sizes)) {
+        results += runSize(rows, dir.path());
+    }
+
+    if (parser.isSet("json")) {
+        QFile out(parser.value("json"));
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            std::fprintf(stderr, "cannot write %s\n", qPrintable(parser.value("json")));
+            return 1;
+        }
+        out.write(QJsonDocument(toJson(results)).toJson());
+    }
+    if (parser.isSet("baseline")) {
+        const int regressions = compareBaseline(results, parser.value("baseline"), tolerance);
+        if (regressions < 0) return 1;
+        if (regressions > 0) {
+            std::printf("%d regression(s) beyond %.0f%%\n", regressions, tolerance * 100);
+            return 4;
+        }
+    }
+    return 0;
+}
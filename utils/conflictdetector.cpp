@@ -0,0 +1,96 @@
+#include "conflictdetector.h"
+#include "dbmanager.h"
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <algorithm>
+
+QString ConflictRecord::describe() const
+{
+    auto fmt = [](qint64 ts) { return DbManager::formatEpoch(ts, QStringLiteral("MM-dd hh:mm")); };
+    return QString("%1: 「%2」(%3-%4) 与 「%5」(%6-%7) 时间冲突")
+            .arg(student,
+                 firstTitle, fmt(firstStart), fmt(firstEnd),
+                 secondTitle, fmt(secondStart), fmt(secondEnd));
+}
+
+QVector<ConflictRecord> ConflictDetector::detect(QVector<EnrollmentSpan> spans)
+{
+    std::sort(spans.begin(), spans.end(), [](const EnrollmentSpan &a, const EnrollmentSpan &b) {
+        if (a.student != b.student) return a.student < b.student;
+        if (a.start != b.start) return a.start < b.start;
+        return a.enrollmentId < b.enrollmentId;
+    });
+
+    QVector<ConflictRecord> out;
+    // 小顶堆（按 end），保存仍与扫描线相交的区间下标
+    std::vector<int> active;
+    auto laterEnd = [&spans](int a, int b) { return spans[a].end > spans[b].end; };
+
+    for (int i = 0; i < spans.size(); ++i) {
+        const EnrollmentSpan &cur = spans[i];
+        if (i > 0 && spans[i - 1].student != cur.student) active.clear();
+        while (!active.empty() && spans[active.front()].end <= cur.start) {
+            std::pop_heap(active.begin(), active.end(), laterEnd);
+            active.pop_back();
+        }
+        // 堆中剩余区间均开始于 cur 之前且结束于 cur 开始之后，即与 cur 重叠
+        for (int idx : active) {
+            const EnrollmentSpan &prev = spans[idx];
+            ConflictRecord r;
+            r.student = cur.student;
+            r.firstActivityId = prev.activityId;
+            r.firstTitle = prev.title;
+            r.firstStart = prev.start;
+            r.firstEnd = prev.end;
+            r.secondActivityId = cur.activityId;
+            r.secondTitle = cur.title;
+            r.secondStart = cur.start;
+            r.secondEnd = cur.end;
+            out << r;
+        }
+        if (cur.end > cur.start) {
+            active.push_back(i);
+            std::push_heap(active.begin(), active.end(), laterEnd);
+        }
+    }
+    return out;
+}
+
+int ConflictDetector::detectSharded(QVector<EnrollmentSpan> spans, const Sink &sink,
+                                    QThreadPool *pool, int shardCount)
+{
+    if (!pool) pool = QThreadPool::globalInstance();
+    if (shardCount <= 0) shardCount = qMax(1, pool->maxThreadCount());
+    if (spans.size() < 1024) shardCount = 1; // 数据量小时分片开销不划算
+
+    if (shardCount == 1) {
+        const QVector<ConflictRecord> records = detect(std::move(spans));
+        if (!records.isEmpty()) sink(records);
+        return records.size();
+    }
+
+    // 同一学生的区间必须落在同一分片
+    QVector<QVector<EnrollmentSpan>> shards(shardCount);
+    for (EnrollmentSpan &s : spans) {
+        shards[int(qHash(s.student) % uint(shardCount))] << std::move(s);
+    }
+    spans.clear();
+
+    QSemaphore done;
+    QAtomicInt total;
+    for (QVector<EnrollmentSpan> &shard : shards) {
+        pool->start([&done, &total, &sink, shard = std::move(shard)]() mutable {
+            const QVector<ConflictRecord> records = detect(std::move(shard));
+            if (!records.isEmpty()) {
+                total.fetchAndAddRelaxed(records.size());
+                sink(records);
+            }
+            done.release();
+        });
+    }
+    done.acquire(shardCount);
+    return total.loadRelaxed();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+class QThreadPool;
+
+// 一条有效报名对应的时间区间（时间为库中 *_ts 整数秒）
+struct EnrollmentSpan {
+    QString student;
+    int enrollmentId { -1 };
+    int activityId { -1 };
+    QString title;
+    qint64 start { 0 };
+    qint64 end { 0 };
+};
+
+// 同一学生两条时间重叠的报名，first 为先开始者
+struct ConflictRecord {
+    QString student;
+    int firstActivityId { -1 };
+    QString firstTitle;
+    qint64 firstStart { 0 };
+    qint64 firstEnd { 0 };
+    int secondActivityId { -1 };
+    QString secondTitle;
+    qint64 secondStart { 0 };
+    qint64 secondEnd { 0 };
+
+    QString describe() const;
+};
+Q_DECLARE_METATYPE(ConflictRecord)
+Q_DECLARE_METATYPE(QVector<ConflictRecord>)
+
+// 全局时间冲突检测：每个学生的区间按开始时间排序后扫描，
+// 用按结束时间排序的小顶堆维护“仍在进行”的区间，复杂度 O(n log n + k)（k 为冲突数）。
+// 学生按哈希分片到线程池并行处理，结果按分片批量回调，不拼接整段文本。
+class ConflictDetector
+{
+public:
+    // 每个分片完成后回调一次；在线程池线程中调用，需自行保证线程安全
+    using Sink = std::function<void(const QVector<ConflictRecord> &)>;
+
+    // 单线程扫描，spans 可包含多个学生，顺序任意
+    static QVector<ConflictRecord> detect(QVector<EnrollmentSpan> spans);
+
+    // 按学生分片并行扫描，全部分片完成后返回冲突总数。
+    // shardCount <= 0 时取线程池的最大线程数
+    static int detectSharded(QVector<EnrollmentSpan> spans, const Sink &sink,
+                             QThreadPool *pool = nullptr, int shardCount = 0);
+};
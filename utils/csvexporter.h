@@ -4,6 +4,7 @@
 #include <QVector>
 #include <QStringList>
 
+// 一次性写出已在内存中的小结果集；大结果集请用 CsvWriter 逐行写出
 class CsvExporter
 {
 public:
@@ -0,0 +1,188 @@
+#include "csvwriter.h"
+
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QVariant>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+inline bool isSpecial(char16_t c)
+{
+    return c == u'"' || c == u',' || c == u'\n' || c == u'\r';
+}
+
+bool needsQuoting(const char16_t *p, qsizetype n)
+{
+    qsizetype i = 0;
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi16('"');
+    const __m128i comma = _mm_set1_epi16(',');
+    const __m128i lf = _mm_set1_epi16('\n');
+    const __m128i cr = _mm_set1_epi16('\r');
+    for (; i + 8 <= n; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        const __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(v, quote), _mm_cmpeq_epi16(v, comma)),
+                                         _mm_or_si128(_mm_cmpeq_epi16(v, lf), _mm_cmpeq_epi16(v, cr)));
+        if (_mm_movemask_epi8(hit)) return true;
+    }
+#endif
+    for (; i < n; ++i) {
+        if (isSpecial(p[i])) return true;
+    }
+    return false;
+}
+
+// 编码 [p, p+n) 为 UTF-8 写入 dst，doubleQuotes 时把 " 写成 ""；返回写入末尾。
+// 孤立的代理项按 U+FFFD 输出
+char *encodeUtf8(char *dst, const char16_t *p, qsizetype n, bool doubleQuotes)
+{
+    qsizetype i = 0;
+#ifdef __SSE2__
+    const __m128i nonAsciiBits = _mm_set1_epi16(short(0xFF80));
+    const __m128i quote = _mm_set1_epi16('"');
+    const __m128i zero = _mm_setzero_si128();
+#endif
+    while (i < n) {
+        qsizetype stop = n;
+#ifdef __SSE2__
+        if (i + 8 <= n) {
+            // 8 个单元全为 ASCII（且无需转义引号）时直接收窄为字节写出
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+            const bool ascii = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, nonAsciiBits), zero)) == 0xFFFF;
+            if (ascii && !(doubleQuotes && _mm_movemask_epi8(_mm_cmpeq_epi16(v, quote)))) {
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(dst), _mm_packus_epi16(v, v));
+                dst += 8;
+                i += 8;
+                continue;
+            }
+            stop = i + 8; // 本组逐字符处理后再尝试向量路径
+        }
+#endif
+        while (i < stop && i < n) {
+            const char16_t c = p[i++];
+            if (c < 0x80) {
+                if (doubleQuotes && c == u'"') *dst++ = '"';
+                *dst++ = char(c);
+            } else if (c < 0x800) {
+                *dst++ = char(0xC0 | (c >> 6));
+                *dst++ = char(0x80 | (c & 0x3F));
+            } else if (QChar::isHighSurrogate(c) && i < n && QChar::isLowSurrogate(p[i])) {
+                const char32_t cp = QChar::surrogateToUcs4(c, p[i++]);
+                *dst++ = char(0xF0 | (cp >> 18));
+                *dst++ = char(0x80 | ((cp >> 12) & 0x3F));
+                *dst++ = char(0x80 | ((cp >> 6) & 0x3F));
+                *dst++ = char(0x80 | (cp & 0x3F));
+            } else {
+                const char16_t u = QChar::isSurrogate(c) ? char16_t(0xFFFD) : c;
+                *dst++ = char(0xE0 | (u >> 12));
+                *dst++ = char(0x80 | ((u >> 6) & 0x3F));
+                *dst++ = char(0x80 | (u & 0x3F));
+            }
+        }
+    }
+    return dst;
+}
+}
+
+CsvWriter::CsvWriter(int bufferBytes)
+    : m_limit(qMax(1024, bufferBytes))
+{
+}
+
+CsvWriter::~CsvWriter()
+{
+    if (m_file.isOpen()) close();
+}
+
+bool CsvWriter::open(const QString &path, QString *error)
+{
+    if (m_file.isOpen()) close();
+    m_file.setFileName(path);
+    m_bytes = 0;
+    m_rows = 0;
+    m_error.clear();
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_error = m_file.errorString();
+        if (error) *error = m_error;
+        return false;
+    }
+    m_buffer.clear();
+    m_buffer.reserve(m_limit + 1024);
+    // UTF-8 BOM，便于 Excel 识别中文
+    m_buffer.append("\xEF\xBB\xBF");
+    return true;
+}
+
+void CsvWriter::writeRow(const QStringList &row)
+{
+    for (int i = 0; i < row.size(); ++i) {
+        if (i > 0) m_buffer.append(',');
+        appendField(m_buffer, row.at(i));
+    }
+    endRow();
+}
+
+qint64 CsvWriter::writeQuery(QSqlQuery &query, const Progress &progress, int interval)
+{
+    const int columns = query.record().count();
+    const int every = qMax(1, interval);
+    qint64 count = 0;
+    while (query.next()) {
+        for (int i = 0; i < columns; ++i) {
+            if (i > 0) m_buffer.append(',');
+            appendField(m_buffer, query.value(i).toString());
+        }
+        endRow();
+        ++count;
+        if (progress && count % every == 0 && !progress(count)) break;
+    }
+    return count;
+}
+
+bool CsvWriter::close(QString *error)
+{
+    if (m_file.isOpen()) {
+        flushBuffer();
+        if (!m_file.flush() && m_error.isEmpty()) m_error = m_file.errorString();
+        m_file.close();
+    }
+    if (error && !m_error.isEmpty()) *error = m_error;
+    return m_error.isEmpty();
+}
+
+void CsvWriter::appendField(QByteArray &out, QStringView value)
+{
+    const char16_t *p = reinterpret_cast<const char16_t *>(value.utf16());
+    const qsizetype n = value.size();
+    const bool quoted = needsQuoting(p, n);
+
+    // 最坏情况：每个 UTF-16 单元 3 字节（引号转义为 2 字节、代理对 4 字节/2 单元均不超过），外加首尾引号
+    const qsizetype old = out.size();
+    out.resize(old + n * 3 + 2);
+    char *dst = out.data() + old;
+    if (quoted) *dst++ = '"';
+    dst = encodeUtf8(dst, p, n, quoted);
+    if (quoted) *dst++ = '"';
+    out.resize(dst - out.constData());
+}
+
+void CsvWriter::endRow()
+{
+    m_buffer.append('\n');
+    ++m_rows;
+    if (m_buffer.size() >= m_limit) flushBuffer();
+}
+
+void CsvWriter::flushBuffer()
+{
+    if (m_buffer.isEmpty()) return;
+    const qint64 written = m_file.write(m_buffer);
+    if (written != m_buffer.size() && m_error.isEmpty()) {
+        m_error = m_file.errorString();
+    }
+    if (written > 0) m_bytes += written;
+    m_buffer.resize(0); // 保留已分配容量，反复复用
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <functional>
+
+class QSqlQuery;
+
+// 流式 CSV 写入：逐行编码为 UTF-8 追加到有界缓冲区，缓冲区满即落盘，
+// 导出大结果集时内存占用与行数无关。
+// 每个字段只扫描一次（SSE2 下 8 个 UTF-16 单元一组），含引号/逗号/换行时按 RFC 4180 加引号，
+// 直接编码进复用的缓冲区，不产生中间 QString/QByteArray。
+class CsvWriter
+{
+public:
+    explicit CsvWriter(int bufferBytes = 64 * 1024);
+    ~CsvWriter();
+
+    bool open(const QString &path, QString *error = nullptr);
+    void writeRow(const QStringList &row);
+    // 每写出 interval 行回调一次（参数为已写行数），返回 false 时停止
+    using Progress = std::function<bool(qint64 rows)>;
+
+    // 从游标当前位置读到末尾，每行写出全部列；返回写出的行数
+    qint64 writeQuery(QSqlQuery &query, const Progress &progress = Progress(), int interval = 1000);
+    // 落盘并关闭；任一写入失败都会在此返回 false
+    bool close(QString *error = nullptr);
+
+    qint64 bytesWritten() const { return m_bytes; }
+    qint64 rowsWritten() const { return m_rows; }
+
+    // 将一个字段（必要时加引号并转义）以 UTF-8 追加到 out
+    static void appendField(QByteArray &out, QStringView value);
+
+private:
+    Q_DISABLE_COPY(CsvWriter)
+
+    void endRow();
+    void flushBuffer();
+
+    QFile m_file;
+    QByteArray m_buffer;
+    int m_limit;
+    qint64 m_bytes { 0 };
+    qint64 m_rows { 0 };
+    QString m_error;
+};
@@ -0,0 +1,65 @@
+#include "intervalindex.h"
+
+#include <algorithm>
+
+namespace {
+bool startsBefore(const IntervalIndex::Interval &a, const IntervalIndex::Interval &b)
+{
+    if (a.start != b.start) return a.start < b.start;
+    return a.enrollmentId < b.enrollmentId;
+}
+}
+
+void IntervalIndex::assign(QVector<Interval> items)
+{
+    std::sort(items.begin(), items.end(), startsBefore);
+    m_items = std::move(items);
+    rebuildFrom(0);
+}
+
+void IntervalIndex::insert(const Interval &item)
+{
+    const auto it = std::upper_bound(m_items.begin(), m_items.end(), item, startsBefore);
+    const int pos = int(it - m_items.begin());
+    m_items.insert(pos, item);
+    rebuildFrom(pos);
+}
+
+bool IntervalIndex::removeEnrollment(int enrollmentId)
+{
+    for (int i = 0; i < m_items.size(); ++i) {
+        if (m_items.at(i).enrollmentId == enrollmentId) {
+            m_items.remove(i);
+            rebuildFrom(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IntervalIndex::containsActivity(int activityId) const
+{
+    return std::any_of(m_items.cbegin(), m_items.cend(),
+                       [activityId](const Interval &i) { return i.activityId == activityId; });
+}
+
+QVector<IntervalIndex::Interval> IntervalIndex::overlapping(qint64 start, qint64 end) const
+{
+    QVector<Interval> out;
+    // 只有开始早于 end 的区间可能重叠
+    const auto it = std::lower_bound(m_items.cbegin(), m_items.cend(), end,
+                                     [](const Interval &i, qint64 value) { return i.start < value; });
+    for (int i = int(it - m_items.cbegin()) - 1; i >= 0 && m_maxEnd.at(i) > start; --i) {
+        if (m_items.at(i).end > start) out.prepend(m_items.at(i));
+    }
+    return out;
+}
+
+void IntervalIndex::rebuildFrom(int pos)
+{
+    m_maxEnd.resize(m_items.size());
+    for (int i = pos; i < m_items.size(); ++i) {
+        const qint64 end = m_items.at(i).end;
+        m_maxEnd[i] = i == 0 ? end : qMax(m_maxEnd.at(i - 1), end);
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+// 单个学生有效报名的时间区间集合，用于报名时的冲突判断。
+// 区间按开始时间有序存放，并维护前缀最大结束时间：
+// 二分定位开始早于查询结束的区间后，若前缀最大结束时间不晚于查询开始即可 O(log n) 判定无冲突，
+// 否则只回溯到前缀最大值不再覆盖查询开始为止。
+class IntervalIndex
+{
+public:
+    struct Interval {
+        int enrollmentId { -1 };
+        int activityId { -1 };
+        QString title;
+        qint64 start { 0 };
+        qint64 end { 0 };
+    };
+
+    void assign(QVector<Interval> items);
+    void insert(const Interval &item);
+    bool removeEnrollment(int enrollmentId);
+    bool containsActivity(int activityId) const;
+
+    // 与 [start, end) 重叠的区间
+    QVector<Interval> overlapping(qint64 start, qint64 end) const;
+
+    int size() const { return m_items.size(); }
+
+private:
+    void rebuildFrom(int pos);
+
+    QVector<Interval> m_items;
+    QVector<qint64> m_maxEnd; // m_maxEnd[i] = max(m_items[0..i].end)
+};